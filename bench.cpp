@@ -0,0 +1,268 @@
+// In-process benchmark of every simulate variant on a single gate buffer.
+//
+// Every variant is compiled into its own namespace, so all of them can be
+// linked into one binary. Build from the repository root after rendering
+// the templates:
+//   python3 simulate_opt90_gen.py && python3 simulate_opt_fusion.py 3
+//   icpx -std=c++17 -xHost -qopenmp -O3 bench.cpp -o bench
+//
+// Usage: ./bench <max_number_of_gates> [repeats] [variant_filter]
+//
+// The gate count is swept over max/64, max/8 and max and the thread count
+// over powers of two up to omp_get_max_threads().
+
+// Included up front so that the variants' own includes are no-ops inside
+// their namespaces.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <immintrin.h>
+#include <iostream>
+#include <numeric>
+#include <omp.h>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Shared headers of the variants. Their include guards would hide them
+// from every namespace but the first.
+#include "gate_tables.h"
+#include "simulate_trace.h"
+
+namespace ref {
+#include "simulate_ref.cpp"
+}
+namespace opt60 {
+#include "simulate_opt60.cpp"
+}
+namespace opt80 {
+#include "simulate_opt80.cpp"
+}
+namespace opt90 {
+#include "simulate_opt90.cpp"
+}
+namespace opt90_trans2 {
+#include "simulate_opt90_trans2.cpp"
+}
+namespace opt90_trans4 {
+#include "simulate_opt90_trans4.cpp"
+}
+namespace fusion3 {
+#include "simulate_opt100_batch3.cpp"
+}
+namespace opt100 {
+#include "simulate_opt100.cpp"
+}
+namespace opt100_group {
+#include "simulate_opt100_group.cpp"
+}
+namespace opt100_dynamic {
+#include "simulate_opt100_dynamic.cpp"
+}
+namespace opt100_streams {
+#include "simulate_opt100_streams.cpp"
+}
+namespace opt100_avx512 {
+#include "simulate_opt100_avx512.cpp"
+}
+namespace opt100_multi {
+#include "simulate_opt100_multi.cpp"
+}
+namespace opt100_vpermb {
+#include "simulate_opt100_vpermb.cpp"
+}
+namespace opt100_perm {
+#include "simulate_opt100_perm.cpp"
+}
+namespace opt100_autotune {
+#include "simulate_opt100_autotune.cpp"
+}
+namespace opt100_prefetch {
+#include "simulate_opt100_prefetch.cpp"
+}
+namespace opt100_constexpr {
+#include "simulate_opt100_constexpr.cpp"
+}
+namespace exact {
+#include "simulate_exact.cpp"
+}
+namespace shard {
+#include "simulate_shard.cpp"
+}
+
+using SimulateFn = void (*)(size_t, const char *, std::complex<double> &,
+                            std::complex<double> &);
+
+struct Variant {
+  const char *Name;
+  SimulateFn Fn;
+};
+
+static const Variant Variants[] = {
+    {"ref", ref::simulate},
+    {"opt60", opt60::simulate},
+    {"opt80", opt80::simulate},
+    {"opt90", opt90::simulate},
+    {"opt90_trans2", opt90_trans2::simulate},
+    {"opt90_trans4", opt90_trans4::simulate},
+    {"fusion3", fusion3::simulate},
+    {"opt100", opt100::simulate},
+    {"opt100_group", opt100_group::simulate},
+    {"opt100_dynamic", opt100_dynamic::simulate},
+    {"opt100_streams", opt100_streams::simulate},
+    {"opt100_avx512", opt100_avx512::simulate},
+    {"opt100_multi", opt100_multi::simulate},
+    {"opt100_vpermb", opt100_vpermb::simulate},
+    {"opt100_perm", opt100_perm::simulate},
+    {"opt100_autotune", opt100_autotune::simulate},
+    {"opt100_prefetch", opt100_prefetch::simulate},
+    {"opt100_constexpr", opt100_constexpr::simulate},
+    {"exact", exact::simulate},
+    // The scan half of driver_shard, composed in-process.
+    {"shard", shard::simulate},
+};
+
+static double elapsedMs(SimulateFn Fn, size_t N, const char *Gates,
+                        std::complex<double> &Alpha,
+                        std::complex<double> &Beta) {
+  auto Start = std::chrono::steady_clock::now();
+  Fn(N, Gates, Alpha, Beta);
+  auto End = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(End - Start).count();
+}
+
+static volatile uint64_t Sink;
+
+// STREAM-style read bandwidth in GB/s. Each gate is one byte, so this is
+// also the upper bound on gates/ns for a kernel that streams the buffer.
+static double readBandwidth(const char *Gates, size_t N, int NumThreads) {
+  double Best = 0;
+  for (int Rep = 0; Rep < 3; ++Rep) {
+    uint64_t Sum = 0;
+    auto Start = std::chrono::steady_clock::now();
+#pragma omp parallel for num_threads(NumThreads) reduction(+ : Sum)
+    for (int I = 0; I < NumThreads; ++I) {
+      size_t Begin = N / 8 * I / NumThreads;
+      size_t End = N / 8 * (I + 1) / NumThreads;
+      uint64_t Local = 0;
+      for (size_t J = Begin; J < End; ++J) {
+        uint64_t Word;
+        memcpy(&Word, Gates + J * 8, sizeof(Word));
+        Local += Word;
+      }
+      Sum += Local;
+    }
+    auto End = std::chrono::steady_clock::now();
+    Sink = Sum;
+    Best = std::max(Best,
+                    N / std::chrono::duration<double, std::nano>(End - Start)
+                            .count());
+  }
+  return Best;
+}
+
+static bool sameState(std::complex<double> A0, std::complex<double> B0,
+                      std::complex<double> A1, std::complex<double> B1) {
+  return std::abs(A0 - A1) < 1e-9 && std::abs(B0 - B1) < 1e-9;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 4) {
+    fprintf(stderr, "Usage: %s <max_number_of_gates> [repeats] [filter]\n",
+            argv[0]);
+    return 1;
+  }
+  size_t MaxN = atoll(argv[1]);
+  int Repeats = argc >= 3 ? atoi(argv[2]) : 5;
+  const char *Filter = argc >= 4 ? argv[3] : "";
+
+  int MaxThreads = omp_get_max_threads();
+  std::vector<int> ThreadCounts;
+  for (int T = 1; T < MaxThreads; T *= 2)
+    ThreadCounts.push_back(T);
+  ThreadCounts.push_back(MaxThreads);
+
+  // The contest kernels need N to be a multiple of 8 x the thread count.
+  size_t Align = 8;
+  for (int T : ThreadCounts)
+    Align = std::lcm<size_t>(Align, 8 * T);
+  std::vector<size_t> Sizes;
+  for (size_t Div : {64, 8, 1})
+    if (MaxN / Div / Align)
+      Sizes.push_back(MaxN / Div / Align * Align);
+  if (Sizes.empty()) {
+    fprintf(stderr, "Need at least %zu gates\n", Align);
+    return 1;
+  }
+
+  std::mt19937 Rng(42);
+  std::uniform_int_distribution<int> Dist(0, 4);
+  std::vector<char> Gates(Sizes.back());
+  for (auto &G : Gates)
+    G = "HXYZS"[Dist(Rng)];
+
+  std::vector<double> Bandwidth;
+  for (int T : ThreadCounts) {
+    Bandwidth.push_back(readBandwidth(Gates.data(), Gates.size(), T));
+    printf("read bandwidth, %2d threads: %8.2f GB/s\n", T, Bandwidth.back());
+  }
+  printf("\n%-16s %12s %7s %11s %9s %9s %9s\n", "variant", "gates",
+         "threads", "time (ms)", "gates/ns", "scaling", "roofline");
+
+  std::vector<std::pair<std::complex<double>, std::complex<double>>> Expected(
+      Sizes.size());
+  for (size_t NI = 0; NI < Sizes.size(); ++NI)
+    ref::simulate(Sizes[NI], Gates.data(), Expected[NI].first,
+                  Expected[NI].second);
+
+  bool Failed = false;
+  std::vector<std::pair<const char *, double>> Summary;
+  for (auto &V : Variants) {
+    if (!strstr(V.Name, Filter))
+      continue;
+    double LogRateSum = 0;
+    for (size_t NI = 0; NI < Sizes.size(); ++NI) {
+      size_t N = Sizes[NI];
+      double SingleRate = 0;
+      for (size_t TI = 0; TI < ThreadCounts.size(); ++TI) {
+        int T = ThreadCounts[TI];
+        omp_set_num_threads(T);
+        std::complex<double> Alpha, Beta;
+        elapsedMs(V.Fn, N, Gates.data(), Alpha, Beta); // Warm-up.
+        double LogSum = 0;
+        for (int Rep = 0; Rep < Repeats; ++Rep)
+          LogSum += std::log(elapsedMs(V.Fn, N, Gates.data(), Alpha, Beta));
+        double Time = std::exp(LogSum / Repeats);
+        if (!sameState(Alpha, Beta, Expected[NI].first, Expected[NI].second)) {
+          printf("%s: wrong result for N = %zu with %d threads\n", V.Name, N,
+                 T);
+          Failed = true;
+        }
+        double Rate = N / (Time * 1e6);
+        if (TI == 0)
+          SingleRate = Rate;
+        printf("%-16s %12zu %7d %11.3f %9.3f %8.1f%% %8.1f%%\n", V.Name, N, T,
+               Time, Rate, 100 * Rate / (SingleRate * T),
+               100 * Rate / Bandwidth[TI]);
+        if (TI + 1 == ThreadCounts.size())
+          LogRateSum += std::log(Rate);
+      }
+    }
+    Summary.push_back({V.Name, std::exp(LogRateSum / Sizes.size())});
+  }
+  omp_set_num_threads(MaxThreads);
+
+  printf("\ngeomean gates/ns with %d threads:\n", MaxThreads);
+  for (auto &[Name, Rate] : Summary)
+    printf("%-16s %9.3f\n", Name, Rate);
+
+  return Failed ? 1 : 0;
+}
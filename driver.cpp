@@ -1,11 +1,198 @@
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <complex>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <omp.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include <vector>
 
-void simulate(size_t N, const char *Gates, std::complex<double> &Alpha,
-              std::complex<double> &Beta);
+// Either entry point may be missing; the header of the input decides which
+// one is needed.
+__attribute__((weak)) void simulate(size_t N, const char *Gates,
+                                    std::complex<double> &Alpha,
+                                    std::complex<double> &Beta);
+__attribute__((weak)) void simulate_packed(size_t N, const uint8_t *Gates,
+                                           std::complex<double> &Alpha,
+                                           std::complex<double> &Beta);
+
+// Set in the header of files whose gates are packed three per byte in base 5.
+static constexpr size_t PackedFlag = size_t(1) << 63;
+
+struct PerfEvent {
+  const char *Name;
+  uint32_t Type;
+  uint64_t Config;
+};
+
+static constexpr uint64_t cacheMiss(uint64_t Cache) {
+  return Cache | PERF_COUNT_HW_CACHE_OP_READ << 8 |
+         PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+}
+
+// L2 misses and stall cycles have no generic event; the raw encodings are
+// L2_RQSTS.MISS and CYCLE_ACTIVITY.STALLS_TOTAL on Skylake-SP.
+static const PerfEvent PerfEvents[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"L1D-misses", PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_L1D)},
+    {"L2-misses", PERF_TYPE_RAW, 0x3F24},
+    {"LLC-misses", PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_LL)},
+    {"dTLB-misses", PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_DTLB)},
+    {"stall-cycles", PERF_TYPE_RAW, 0x04A3 | 4ull << 24},
+};
+static constexpr size_t NumPerfEvents =
+    sizeof(PerfEvents) / sizeof(PerfEvents[0]);
+
+// Hardware counters for every OpenMP thread, enabled only around simulate.
+// simulate's parallel regions reuse the same thread pool, so counters opened
+// on each thread here follow that thread's chunk.
+class PerfCounters {
+  int NumThreads;
+  std::vector<int> Fds;
+
+  int &fd(int Thread, size_t Event) {
+    return Fds[Thread * NumPerfEvents + Event];
+  }
+
+public:
+  PerfCounters()
+      : NumThreads(omp_get_max_threads()),
+        Fds(NumThreads * NumPerfEvents, -1) {
+#pragma omp parallel num_threads(NumThreads)
+    {
+      int Thread = omp_get_thread_num();
+      for (size_t E = 0; E < NumPerfEvents; ++E) {
+        perf_event_attr Attr = {};
+        Attr.size = sizeof(Attr);
+        Attr.type = PerfEvents[E].Type;
+        Attr.config = PerfEvents[E].Config;
+        Attr.disabled = 1;
+        Attr.exclude_kernel = 1;
+        Attr.exclude_hv = 1;
+        Attr.read_format =
+            PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        fd(Thread, E) = syscall(SYS_perf_event_open, &Attr, 0, -1, -1, 0);
+      }
+    }
+  }
+  ~PerfCounters() {
+    for (int Fd : Fds)
+      if (Fd >= 0)
+        close(Fd);
+  }
+
+  void start() {
+    for (int Fd : Fds)
+      if (Fd >= 0) {
+        ioctl(Fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(Fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+  }
+  void stop() {
+    for (int Fd : Fds)
+      if (Fd >= 0)
+        ioctl(Fd, PERF_EVENT_IOC_DISABLE, 0);
+  }
+
+  // Scaled for multiplexing; -1 if the event is unavailable.
+  double read(int Thread, size_t Event) {
+    uint64_t Values[3];
+    int Fd = fd(Thread, Event);
+    if (Fd < 0 || ::read(Fd, Values, sizeof(Values)) != sizeof(Values))
+      return -1;
+    return Values[2] ? double(Values[0]) * Values[1] / Values[2] : 0;
+  }
+
+  void print() {
+    std::vector<double> Total(NumPerfEvents, 0);
+    std::vector<double> Row(NumPerfEvents);
+    for (int T = 0; T < NumThreads; ++T) {
+      printf("Thread %2d:", T);
+      for (size_t E = 0; E < NumPerfEvents; ++E) {
+        Row[E] = read(T, E);
+        if (Row[E] < 0 || Total[E] < 0)
+          Total[E] = -1;
+        else
+          Total[E] += Row[E];
+        if (Row[E] < 0)
+          printf(" %s n/a", PerfEvents[E].Name);
+        else
+          printf(" %s %.0f", PerfEvents[E].Name, Row[E]);
+      }
+      printf("\n");
+    }
+    printf("Counters:");
+    for (size_t E = 0; E < NumPerfEvents; ++E) {
+      if (Total[E] < 0)
+        printf(" %s n/a", PerfEvents[E].Name);
+      else
+        printf(" %s %.0f", PerfEvents[E].Name, Total[E]);
+    }
+    if (Total[0] > 0 && Total[1] >= 0)
+      printf(" IPC %.3f", Total[1] / Total[0]);
+    printf("\n");
+  }
+};
+
+static constexpr size_t HugePageSize = size_t(2) << 20;
+
+// Anonymous memory backed by 2 MB pages: hugetlbfs pages if any are
+// reserved, otherwise 2 MB-aligned memory advised for transparent huge
+// pages. Size must be a multiple of HugePageSize.
+static char *allocHugePages(size_t Size, const char *&Kind) {
+#ifdef MAP_HUGETLB
+  void *Ptr = mmap(nullptr, Size, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (Ptr != MAP_FAILED) {
+    Kind = "hugetlbfs";
+    return static_cast<char *>(Ptr);
+  }
+#endif
+  // Over-allocate, then trim to a 2 MB-aligned range.
+  void *Raw = mmap(nullptr, Size + HugePageSize, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (Raw == MAP_FAILED)
+    return nullptr;
+  uintptr_t Begin = reinterpret_cast<uintptr_t>(Raw);
+  uintptr_t Aligned = (Begin + HugePageSize - 1) & ~(HugePageSize - 1);
+  if (Aligned != Begin)
+    munmap(Raw, Aligned - Begin);
+  munmap(reinterpret_cast<void *>(Aligned + Size),
+         Begin + HugePageSize - Aligned);
+#ifdef MADV_HUGEPAGE
+  madvise(reinterpret_cast<void *>(Aligned), Size, MADV_HUGEPAGE);
+#endif
+  Kind = "transparent";
+  return reinterpret_cast<char *>(Aligned);
+}
+
+static volatile char TouchSink;
+
+// Fault the pages of a mapping in before timing starts.
+// MADV_POPULATE_READ needs Linux 5.14 and fails with EINVAL on older
+// kernels, whatever the headers say; then read one byte of every page.
+static void populate(void *Map, size_t Size) {
+#ifdef MADV_POPULATE_READ
+  if (madvise(Map, Size, MADV_POPULATE_READ) == 0)
+    return;
+#endif
+  const char *Bytes = static_cast<const char *>(Map);
+  size_t PageSize = sysconf(_SC_PAGESIZE);
+  char Sum = 0;
+  for (size_t I = 0; I < Size; I += PageSize)
+    Sum ^= Bytes[I];
+  TouchSink = Sum;
+}
 
 int main(int argc, char *argv[]) {
   if (argc != 2) {
@@ -14,32 +201,122 @@ int main(int argc, char *argv[]) {
   }
 
   const char *output_file = argv[1];
-  FILE *file = fopen(output_file, "rb");
-  if (!file) {
+  int Fd = open(output_file, O_RDONLY);
+  if (Fd < 0) {
     perror("Failed to open file");
     return 1;
   }
 
+  struct stat Stat;
+  if (fstat(Fd, &Stat) != 0 || Stat.st_size < (off_t)sizeof(size_t)) {
+    fprintf(stderr, "Invalid input file\n");
+    return 1;
+  }
+  size_t FileSize = Stat.st_size;
+
+  // Map the file instead of copying it. The mapping is page-aligned, so the
+  // gates following the 8-byte header stay 8-byte aligned.
+  void *Map = mmap(nullptr, FileSize, PROT_READ, MAP_PRIVATE, Fd, 0);
+  close(Fd);
+  if (Map == MAP_FAILED) {
+    perror("Failed to map file");
+    return 1;
+  }
+  madvise(Map, FileSize, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+  madvise(Map, FileSize, MADV_HUGEPAGE);
+#endif
+  populate(Map, FileSize);
+
   size_t N;
-  [[maybe_unused]] auto Res1 = fread(&N, sizeof(size_t), 1, file);
-  std::vector<char> Gates(N);
-  [[maybe_unused]] auto Res2 = fread(Gates.data(), sizeof(char), N, file);
-  fclose(file);
+  memcpy(&N, Map, sizeof(size_t));
+  bool Packed = N & PackedFlag;
+  N &= ~PackedFlag;
+  if ((Packed ? (N + 2) / 3 : N) > FileSize - sizeof(size_t)) {
+    fprintf(stderr, "Truncated input file\n");
+    return 1;
+  }
+  const char *Gates = static_cast<const char *>(Map) + sizeof(size_t);
+
+  // Without a packed kernel, expand packed input back to one byte per gate.
+  std::vector<char> Unpacked;
+  if (Packed && !simulate_packed) {
+    Unpacked.resize(N);
+    for (size_t I = 0; I < N; ++I) {
+      uint8_t Byte = Gates[I / 3];
+      uint8_t Gate = I % 3 == 0   ? Byte / 25
+                     : I % 3 == 1 ? Byte / 5 % 5
+                                  : Byte % 5;
+      Unpacked[I] = "HXYZS"[Gate];
+    }
+    Packed = false;
+    Gates = Unpacked.data();
+  }
+  if (!Packed && !simulate) {
+    fprintf(stderr, "No kernel for unpacked input\n");
+    return 1;
+  }
+
+  // SIMULATE_HUGEPAGES=1 copies the gates into memory backed by 2 MB pages
+  // before timing. Page-cache pages of the mapped file are 4 KB, so a long
+  // scan of the mapping misses the dTLB once every 4 KB.
+  const char *Huge = getenv("SIMULATE_HUGEPAGES");
+  char *HugeGates = nullptr;
+  size_t HugeSize = 0;
+  if (Huge && strcmp(Huge, "1") == 0) {
+    size_t Bytes = Packed ? (N + 2) / 3 : N;
+    HugeSize = std::max<size_t>(Bytes, 1);
+    HugeSize = (HugeSize + HugePageSize - 1) / HugePageSize * HugePageSize;
+    const char *Kind = nullptr;
+    HugeGates = allocHugePages(HugeSize, Kind);
+    if (!HugeGates) {
+      perror("Failed to allocate huge pages");
+      return 1;
+    }
+    memcpy(HugeGates, Gates, Bytes);
+    Gates = HugeGates;
+    // Drop the source right away so that only one copy stays resident.
+    munmap(Map, FileSize);
+    Map = nullptr;
+    std::vector<char>().swap(Unpacked);
+    fprintf(stderr, "Gates backed by %s huge pages\n", Kind);
+  }
 
   std::complex<double> Alpha = {}, Beta = {};
 
+  // SIMULATE_PERF=1 reports hardware counters for the simulate call.
+  const char *Perf = getenv("SIMULATE_PERF");
+  PerfCounters *Counters =
+      Perf && strcmp(Perf, "1") == 0 ? new PerfCounters() : nullptr;
+  if (Counters)
+    Counters->start();
+
   std::atomic_signal_fence(std::memory_order_acq_rel);
   auto start = std::chrono::high_resolution_clock::now();
   std::atomic_signal_fence(std::memory_order_acq_rel);
-  simulate(N, Gates.data(), Alpha, Beta);
+  if (Packed)
+    simulate_packed(N, reinterpret_cast<const uint8_t *>(Gates), Alpha, Beta);
+  else
+    simulate(N, Gates, Alpha, Beta);
   std::atomic_signal_fence(std::memory_order_acq_rel);
   auto end = std::chrono::high_resolution_clock::now();
   std::atomic_signal_fence(std::memory_order_acq_rel);
+  if (Counters)
+    Counters->stop();
+
+  if (Map)
+    munmap(Map, FileSize);
+  if (HugeGates)
+    munmap(HugeGates, HugeSize);
 
   std::chrono::duration<double, std::milli> duration = end - start;
   printf("Final state: alpha = %.12f + %.12fi, beta = %.12f + %.12fi\n",
          Alpha.real(), Alpha.imag(), Beta.real(), Beta.imag());
   printf("Time taken: %.2f ms\n", duration.count());
+  if (Counters) {
+    Counters->print();
+    delete Counters;
+  }
 
   return 0;
 }
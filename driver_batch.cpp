@@ -0,0 +1,68 @@
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Circuit I is the Lengths[I] gates at Gates + Offsets[I].
+void simulate_batch(size_t NumCircuits, const char *Gates,
+                    const size_t *Offsets, const size_t *Lengths,
+                    std::complex<double> *Alphas, std::complex<double> *Betas);
+
+// Set in the header of files whose gates are packed three per byte in base 5.
+static constexpr size_t PackedFlag = size_t(1) << 63;
+
+// Runs every input file as one circuit of a single simulate_batch call, e.g.
+//   ./driver_batch data/*.in
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <input_file>...\n", argv[0]);
+    return 1;
+  }
+
+  size_t NumCircuits = argc - 1;
+  std::vector<size_t> Offsets(NumCircuits), Lengths(NumCircuits);
+  std::vector<char> Gates;
+  for (size_t I = 0; I < NumCircuits; ++I) {
+    FILE *File = fopen(argv[I + 1], "rb");
+    if (!File) {
+      perror("Failed to open file");
+      return 1;
+    }
+    size_t N;
+    if (fread(&N, sizeof(size_t), 1, File) != 1 || N & PackedFlag) {
+      fprintf(stderr, "Invalid input file %s\n", argv[I + 1]);
+      return 1;
+    }
+    Offsets[I] = Gates.size();
+    Lengths[I] = N;
+    Gates.resize(Gates.size() + N);
+    if (fread(Gates.data() + Offsets[I], 1, N, File) != N) {
+      fprintf(stderr, "Failed to read file %s\n", argv[I + 1]);
+      return 1;
+    }
+    fclose(File);
+  }
+
+  std::vector<std::complex<double>> Alphas(NumCircuits), Betas(NumCircuits);
+
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  auto start = std::chrono::high_resolution_clock::now();
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  simulate_batch(NumCircuits, Gates.data(), Offsets.data(), Lengths.data(),
+                 Alphas.data(), Betas.data());
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+
+  std::chrono::duration<double, std::milli> duration = end - start;
+  for (size_t I = 0; I < NumCircuits; ++I)
+    printf("%s: Final state: alpha = %.12f + %.12fi, beta = %.12f + %.12fi\n",
+           argv[I + 1], Alphas[I].real(), Alphas[I].imag(), Betas[I].real(),
+           Betas[I].imag());
+  printf("Time taken: %.2f ms for %zu circuits, %zu gates\n", duration.count(),
+         NumCircuits, Gates.size());
+
+  return 0;
+}
@@ -0,0 +1,85 @@
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+struct Circuit;
+Circuit *circuit_create(size_t N, const char *Gates,
+                        std::complex<double> &Alpha,
+                        std::complex<double> &Beta);
+void circuit_destroy(Circuit *C);
+size_t circuit_size(const Circuit *C);
+void circuit_update(Circuit *C, size_t Pos, char Gate,
+                    std::complex<double> &Alpha, std::complex<double> &Beta);
+void circuit_insert(Circuit *C, size_t Pos, char Gate,
+                    std::complex<double> &Alpha, std::complex<double> &Beta);
+void circuit_erase(Circuit *C, size_t Pos, std::complex<double> &Alpha,
+                   std::complex<double> &Beta);
+
+// Set in the header of files whose gates are packed three per byte in base 5.
+static constexpr size_t PackedFlag = size_t(1) << 63;
+
+// Loads a circuit, then applies random single-gate edits (one third each of
+// updates, inserts and erases) and reports the time per edit.
+int main(int argc, char *argv[]) {
+  if (argc < 3 || argc > 4) {
+    fprintf(stderr, "Usage: %s <input_file> <number_of_edits> [seed]\n",
+            argv[0]);
+    return 1;
+  }
+  size_t NumEdits = atoll(argv[2]);
+  std::mt19937_64 Rng(argc == 4 ? atoll(argv[3]) : 0);
+
+  FILE *File = fopen(argv[1], "rb");
+  if (!File) {
+    perror("Failed to open file");
+    return 1;
+  }
+  size_t N;
+  if (fread(&N, sizeof(size_t), 1, File) != 1 || N & PackedFlag) {
+    fprintf(stderr, "Invalid input file\n");
+    return 1;
+  }
+  std::vector<char> Gates(N);
+  if (fread(Gates.data(), 1, N, File) != N) {
+    fprintf(stderr, "Failed to read file\n");
+    return 1;
+  }
+  fclose(File);
+
+  std::complex<double> Alpha = {}, Beta = {};
+  auto start = std::chrono::high_resolution_clock::now();
+  Circuit *C = circuit_create(N, Gates.data(), Alpha, Beta);
+  auto mid = std::chrono::high_resolution_clock::now();
+  for (size_t I = 0; I < NumEdits; ++I) {
+    size_t Size = circuit_size(C);
+    char Gate = "HXYZS"[Rng() % 5];
+    switch (Size ? Rng() % 3 : 1) {
+    case 0:
+      circuit_update(C, Rng() % Size, Gate, Alpha, Beta);
+      break;
+    case 1:
+      circuit_insert(C, Rng() % (Size + 1), Gate, Alpha, Beta);
+      break;
+    case 2:
+      circuit_erase(C, Rng() % Size, Alpha, Beta);
+      break;
+    }
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  size_t FinalSize = circuit_size(C);
+  circuit_destroy(C);
+
+  std::chrono::duration<double, std::milli> Build = mid - start;
+  std::chrono::duration<double, std::micro> Edits = end - mid;
+  printf("Final state: alpha = %.12f + %.12fi, beta = %.12f + %.12fi\n",
+         Alpha.real(), Alpha.imag(), Beta.real(), Beta.imag());
+  printf("Build: %.2f ms, %zu edits: %.3f us/edit, final size %zu\n",
+         Build.count(), NumEdits, NumEdits ? Edits.count() / NumEdits : 0.0,
+         FinalSize);
+
+  return 0;
+}
@@ -0,0 +1,39 @@
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+void simulate_generated(size_t N, uint64_t Seed, std::complex<double> &Alpha,
+                        std::complex<double> &Beta);
+
+// Simulate the circuit that "gen <length> <file> seed=<seed>" would write,
+// generating the gates on the fly instead of reading them. The timing
+// includes generation.
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <length> <seed>\n", argv[0]);
+    return 1;
+  }
+
+  size_t N = std::atoll(argv[1]);
+  uint64_t Seed = std::strtoull(argv[2], nullptr, 0);
+
+  std::complex<double> Alpha = {}, Beta = {};
+
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  auto start = std::chrono::high_resolution_clock::now();
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  simulate_generated(N, Seed, Alpha, Beta);
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+
+  std::chrono::duration<double, std::milli> duration = end - start;
+  printf("Final state: alpha = %.12f + %.12fi, beta = %.12f + %.12fi\n",
+         Alpha.real(), Alpha.imag(), Beta.real(), Beta.imag());
+  printf("Time taken: %.2f ms\n", duration.count());
+
+  return 0;
+}
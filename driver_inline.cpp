@@ -2,9 +2,12 @@
 #include <chrono>
 #include <complex>
 #include <cstdio>
-#include <random>
+#include <cstdlib>
+#include <omp.h>
 #include <vector>
 
+#include "philox.h"
+
 void simulate(size_t N, const char *Gates, std::complex<double> &Alpha,
               std::complex<double> &Beta);
 
@@ -15,14 +18,16 @@ int main(int argc, char *argv[]) {
   }
 
   size_t N = std::atoll(argv[1]);
-  size_t Seed = std::atoll(argv[2]);
+  uint64_t Seed = std::strtoull(argv[2], nullptr, 0);
 
-  std::mt19937 Rng(Seed);
-  std::uniform_int_distribution<int> Dist(0, 4);
+  // Every thread generates its own slice of the stream.
   std::vector<char> Gates(N);
-  for (size_t i = 0; i < N; ++i) {
-    int gate = Dist(Rng);
-    Gates[i] = "HXYZS"[gate];
+#pragma omp parallel
+  {
+    int I = omp_get_thread_num();
+    int NumThreads = omp_get_num_threads();
+    size_t Start = N * I / NumThreads, End = N * (I + 1) / NumThreads;
+    philoxGates(Seed, Start, End - Start, Gates.data() + Start);
   }
 
   std::complex<double> Alpha = {}, Beta = {};
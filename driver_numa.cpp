@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <omp.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+void simulate(size_t N, const char *Gates, std::complex<double> &Alpha,
+              std::complex<double> &Beta);
+
+// Set in the header of files whose gates are packed three per byte in base 5.
+static constexpr size_t PackedFlag = size_t(1) << 63;
+
+struct Cpu {
+  int Id, Socket, Core;
+};
+
+static int readTopology(int CpuId, const char *Name) {
+  char Path[128];
+  snprintf(Path, sizeof(Path), "/sys/devices/system/cpu/cpu%d/topology/%s",
+           CpuId, Name);
+  FILE *File = fopen(Path, "r");
+  if (!File)
+    return 0;
+  int Val = 0;
+  if (fscanf(File, "%d", &Val) != 1)
+    Val = 0;
+  fclose(File);
+  return Val;
+}
+
+// Usable CPUs ordered by socket and core, so that consecutive chunks (and
+// therefore consecutive threads) land on the same socket.
+static std::vector<Cpu> getCpus() {
+  cpu_set_t Set;
+  CPU_ZERO(&Set);
+  sched_getaffinity(0, sizeof(Set), &Set);
+  std::vector<Cpu> Cpus;
+  for (int I = 0; I < CPU_SETSIZE; ++I)
+    if (CPU_ISSET(I, &Set))
+      Cpus.push_back({I, readTopology(I, "physical_package_id"),
+                      readTopology(I, "core_id")});
+  // Put SMT siblings last so that each thread gets a physical core first.
+  std::vector<Cpu> Primary, Siblings;
+  for (auto &C : Cpus) {
+    bool Seen = std::any_of(Primary.begin(), Primary.end(), [&](const Cpu &P) {
+      return P.Socket == C.Socket && P.Core == C.Core;
+    });
+    (Seen ? Siblings : Primary).push_back(C);
+  }
+  auto Less = [](const Cpu &A, const Cpu &B) {
+    if (A.Socket != B.Socket)
+      return A.Socket < B.Socket;
+    return A.Id < B.Id;
+  };
+  std::stable_sort(Primary.begin(), Primary.end(), Less);
+  std::stable_sort(Siblings.begin(), Siblings.end(), Less);
+  Primary.insert(Primary.end(), Siblings.begin(), Siblings.end());
+  return Primary;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s <input_file>\n", argv[0]);
+    return 1;
+  }
+
+  const char *output_file = argv[1];
+  int Fd = open(output_file, O_RDONLY);
+  if (Fd < 0) {
+    perror("Failed to open file");
+    return 1;
+  }
+
+  size_t N;
+  if (pread(Fd, &N, sizeof(size_t), 0) != sizeof(size_t) || N & PackedFlag) {
+    fprintf(stderr, "Invalid input file\n");
+    return 1;
+  }
+
+  // Pin thread I to the I-th CPU. simulate splits the gates into one chunk
+  // per thread with a static schedule, so chunk I is always scanned on CPU I.
+  std::vector<Cpu> Cpus = getCpus();
+  if (Cpus.empty()) {
+    fprintf(stderr, "No usable CPUs in the affinity mask\n");
+    return 1;
+  }
+  int NumThreads = omp_get_max_threads();
+  int NumSockets = 0;
+  std::vector<int> SocketOf(NumThreads);
+#pragma omp parallel num_threads(NumThreads)
+  {
+    int I = omp_get_thread_num();
+    const Cpu &C = Cpus[I % Cpus.size()];
+    cpu_set_t Set;
+    CPU_ZERO(&Set);
+    CPU_SET(C.Id, &Set);
+    sched_setaffinity(0, sizeof(Set), &Set);
+    SocketOf[I] = C.Socket;
+  }
+  for (int S : SocketOf)
+    NumSockets = std::max(NumSockets, S + 1);
+
+  // Leave the buffer untouched here and let each pinned thread fault in and
+  // fill its own chunk, so that the pages are allocated on its socket.
+  char *Gates = static_cast<char *>(mmap(nullptr, std::max<size_t>(N, 1),
+                                         PROT_READ | PROT_WRITE,
+                                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (Gates == MAP_FAILED) {
+    perror("Failed to allocate gates");
+    return 1;
+  }
+#ifdef MADV_HUGEPAGE
+  madvise(Gates, N, MADV_HUGEPAGE);
+#endif
+
+  std::atomic<bool> ReadFailed{false};
+#pragma omp parallel for
+  for (int I = 0; I < NumThreads; ++I) {
+    size_t Start = N * I / NumThreads;
+    size_t End = N * (I + 1) / NumThreads;
+    while (Start < End) {
+      ssize_t Res = pread(Fd, Gates + Start, End - Start,
+                          sizeof(size_t) + Start);
+      if (Res <= 0) {
+        ReadFailed = true;
+        break;
+      }
+      Start += Res;
+    }
+  }
+  close(Fd);
+  if (ReadFailed) {
+    fprintf(stderr, "Failed to read file\n");
+    return 1;
+  }
+
+  // Measure how fast each socket streams its own chunks.
+  std::vector<double> Seconds(NumThreads);
+#pragma omp parallel for
+  for (int I = 0; I < NumThreads; ++I) {
+    size_t Start = N * I / NumThreads;
+    size_t End = N * (I + 1) / NumThreads;
+    auto T0 = std::chrono::steady_clock::now();
+    uint64_t Sum = 0;
+    for (size_t J = Start; J < End; ++J)
+      Sum += static_cast<unsigned char>(Gates[J]);
+    // Keep the sum, and with it the loop, from being optimized away.
+    asm volatile("" : : "r"(Sum));
+    auto T1 = std::chrono::steady_clock::now();
+    Seconds[I] = std::chrono::duration<double>(T1 - T0).count();
+  }
+  for (int S = 0; S < NumSockets; ++S) {
+    int Threads = 0;
+    double Bytes = 0, MaxSeconds = 0;
+    for (int I = 0; I < NumThreads; ++I) {
+      if (SocketOf[I] != S)
+        continue;
+      ++Threads;
+      Bytes += N * (I + 1) / NumThreads - N * I / NumThreads;
+      MaxSeconds = std::max(MaxSeconds, Seconds[I]);
+    }
+    if (Threads)
+      printf("Socket %d: %d threads, %.2f GB/s\n", S, Threads,
+             MaxSeconds > 0 ? Bytes / MaxSeconds / 1e9 : 0.0);
+  }
+
+  std::complex<double> Alpha = {}, Beta = {};
+
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  auto start = std::chrono::high_resolution_clock::now();
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  simulate(N, Gates, Alpha, Beta);
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+
+  munmap(Gates, std::max<size_t>(N, 1));
+
+  std::chrono::duration<double, std::milli> duration = end - start;
+  printf("Final state: alpha = %.12f + %.12fi, beta = %.12f + %.12fi\n",
+         Alpha.real(), Alpha.imag(), Beta.real(), Beta.imag());
+  printf("Time taken: %.2f ms\n", duration.count());
+
+  return 0;
+}
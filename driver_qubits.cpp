@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <omp.h>
+#include <vector>
+
+struct QubitGate {
+  char Kind;
+  uint16_t Target, Control;
+};
+
+void simulate_qubits(size_t N, const QubitGate *Gates, unsigned NumQubits,
+                     std::complex<double> *State);
+
+// Set in the header of n-qubit circuits. The header is followed by the number
+// of qubits and then by one QubitGate record per gate.
+static constexpr size_t QubitsFlag = size_t(1) << 62;
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s <input_file>\n", argv[0]);
+    return 1;
+  }
+
+  FILE *File = fopen(argv[1], "rb");
+  if (!File) {
+    perror("Failed to open file");
+    return 1;
+  }
+  size_t Header, NumQubits;
+  if (fread(&Header, sizeof(size_t), 1, File) != 1 ||
+      !(Header & QubitsFlag) ||
+      fread(&NumQubits, sizeof(size_t), 1, File) != 1 || NumQubits > 40) {
+    fprintf(stderr, "Invalid input file\n");
+    return 1;
+  }
+  size_t N = Header & ~QubitsFlag;
+  std::vector<QubitGate> Gates(N);
+  if (fread(Gates.data(), sizeof(QubitGate), N, File) != N) {
+    fprintf(stderr, "Failed to read file\n");
+    return 1;
+  }
+  fclose(File);
+  for (auto &G : Gates) {
+    if (G.Target >= NumQubits ||
+        (G.Kind == 'C' && (G.Control >= NumQubits || G.Control == G.Target))) {
+      fprintf(stderr, "Invalid gate\n");
+      return 1;
+    }
+  }
+
+  // Let every thread fault in the part of the vector it will work on.
+  size_t Size = size_t(1) << NumQubits;
+  size_t Bytes = std::max<size_t>(Size, 4) * sizeof(std::complex<double>);
+  auto *State = static_cast<std::complex<double> *>(aligned_alloc(64, Bytes));
+  if (!State) {
+    perror("Failed to allocate the state vector");
+    return 1;
+  }
+#pragma omp parallel for schedule(static)
+  for (size_t I = 0; I < Size; ++I)
+    State[I] = 0;
+  State[0] = 1;
+
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  auto start = std::chrono::high_resolution_clock::now();
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  simulate_qubits(N, Gates.data(), NumQubits, State);
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+
+  double Norm = 0, MaxProb = 0;
+  size_t MaxIndex = 0;
+  for (size_t I = 0; I < Size; ++I) {
+    double Prob = std::norm(State[I]);
+    Norm += Prob;
+    if (Prob > MaxProb) {
+      MaxProb = Prob;
+      MaxIndex = I;
+    }
+  }
+
+  std::chrono::duration<double, std::milli> duration = end - start;
+  printf("Final state: amp[0] = %.12f + %.12fi, amp[%zu] = %.12f + %.12fi\n",
+         State[0].real(), State[0].imag(), MaxIndex, State[MaxIndex].real(),
+         State[MaxIndex].imag());
+  printf("Norm: %.12f, most likely basis state %zu with p = %.6f\n", Norm,
+         MaxIndex, MaxProb);
+  printf("Time taken: %.2f ms\n", duration.count());
+
+  free(State);
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// Axis is 'X', 'Y' or 'Z' for Rx, Ry or Rz by Theta radians.
+struct RotationGate {
+  char Axis;
+  double Theta;
+};
+
+void simulate_rotations(size_t N, const RotationGate *Gates, bool Compensated,
+                        std::complex<double> &Alpha,
+                        std::complex<double> &Beta);
+
+// Set in the header of rotation circuits, whose gates are RotationGate
+// records.
+static constexpr size_t RotationFlag = size_t(1) << 61;
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 3 ||
+      (argc == 3 && strcmp(argv[2], "compensated") != 0)) {
+    fprintf(stderr, "Usage: %s <input_file> [compensated]\n", argv[0]);
+    return 1;
+  }
+  bool Compensated = argc == 3;
+
+  FILE *File = fopen(argv[1], "rb");
+  if (!File) {
+    perror("Failed to open file");
+    return 1;
+  }
+  size_t Header;
+  if (fread(&Header, sizeof(size_t), 1, File) != 1 ||
+      !(Header & RotationFlag)) {
+    fprintf(stderr, "Invalid input file\n");
+    return 1;
+  }
+  size_t N = Header & ~RotationFlag;
+  std::vector<RotationGate> Gates(N);
+  if (fread(Gates.data(), sizeof(RotationGate), N, File) != N) {
+    fprintf(stderr, "Failed to read file\n");
+    return 1;
+  }
+  fclose(File);
+  for (auto &G : Gates) {
+    if (G.Axis != 'X' && G.Axis != 'Y' && G.Axis != 'Z') {
+      fprintf(stderr, "Invalid gate\n");
+      return 1;
+    }
+  }
+
+  std::complex<double> Alpha = {}, Beta = {};
+
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  auto start = std::chrono::high_resolution_clock::now();
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  simulate_rotations(N, Gates.data(), Compensated, Alpha, Beta);
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+
+  std::chrono::duration<double, std::milli> duration = end - start;
+  printf("Final state: alpha = %.12f + %.12fi, beta = %.12f + %.12fi\n",
+         Alpha.real(), Alpha.imag(), Beta.real(), Beta.imag());
+  printf("Time taken: %.2f ms\n", duration.count());
+
+  return 0;
+}
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <omp.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "shard_transport.h"
+
+uint32_t simulate_summary(size_t N, const char *Gates);
+uint32_t compose_summaries(const uint32_t *Summaries, size_t Count);
+void summary_state(uint32_t Summary, std::complex<double> &Alpha,
+                   std::complex<double> &Beta);
+
+// Set in the header of files whose gates are packed three per byte in base 5.
+static constexpr size_t PackedFlag = size_t(1) << 63;
+
+// Read the gate count and check that the file holds every gate, so that no
+// worker maps past the end of the file and dies of SIGBUS.
+static bool readLength(const char *Path, size_t &N) {
+  int Fd = open(Path, O_RDONLY);
+  if (Fd < 0) {
+    perror("Failed to open file");
+    return false;
+  }
+  struct stat Stat;
+  bool Ok = fstat(Fd, &Stat) == 0 &&
+            pread(Fd, &N, sizeof(size_t), 0) == sizeof(size_t) &&
+            !(N & PackedFlag);
+  close(Fd);
+  if (!Ok) {
+    fprintf(stderr, "Invalid input file\n");
+    return false;
+  }
+  if (size_t(Stat.st_size) - sizeof(size_t) < N) {
+    fprintf(stderr, "Truncated input file\n");
+    return false;
+  }
+  return true;
+}
+
+// How long the coordinator waits for all summaries. Workers that crash
+// before publishing are only noticed this way in coordinate mode.
+static Deadline collectDeadline() {
+  const char *Env = getenv("SIMULATE_SHARD_TIMEOUT");
+  double Seconds = Env ? atof(Env) : 600;
+  return std::chrono::steady_clock::now() +
+         std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+             std::chrono::duration<double>(Seconds));
+}
+
+// Shard I of Shards covers gates [N * I / Shards, N * (I + 1) / Shards).
+static size_t shardStart(size_t N, uint32_t I, uint32_t Shards) {
+  return static_cast<size_t>(static_cast<unsigned __int128>(N) * I / Shards);
+}
+
+// Map only the bytes of shard I, so that each process touches its own part
+// of the file and the whole input never has to fit in one process.
+static bool scanShard(const char *Path, uint32_t I, uint32_t Shards,
+                      ShardSummary &Out) {
+  size_t N;
+  if (!readLength(Path, N))
+    return false;
+  size_t Start = shardStart(N, I, Shards);
+  size_t Size = shardStart(N, I + 1, Shards) - Start;
+  Out = {I, FailedSummary, Size};
+  if (Size == 0) {
+    Out.Summary = simulate_summary(0, nullptr);
+    return true;
+  }
+
+  int Fd = open(Path, O_RDONLY);
+  if (Fd < 0) {
+    perror("Failed to open file");
+    return false;
+  }
+  size_t Offset = sizeof(size_t) + Start;
+  size_t Skip = Offset % sysconf(_SC_PAGESIZE);
+  void *Map =
+      mmap(nullptr, Skip + Size, PROT_READ, MAP_PRIVATE, Fd, Offset - Skip);
+  close(Fd);
+  if (Map == MAP_FAILED) {
+    perror("Failed to map file");
+    return false;
+  }
+  madvise(Map, Skip + Size, MADV_SEQUENTIAL);
+#ifdef MADV_POPULATE_READ
+  madvise(Map, Skip + Size, MADV_POPULATE_READ);
+#endif
+
+  auto T0 = std::chrono::steady_clock::now();
+  Out.Summary = simulate_summary(Size, static_cast<const char *>(Map) + Skip);
+  auto T1 = std::chrono::steady_clock::now();
+  munmap(Map, Skip + Size);
+
+  printf("Shard %u: %zu gates in %.2f ms\n", I, Size,
+         std::chrono::duration<double, std::milli>(T1 - T0).count());
+  fflush(stdout);
+  return true;
+}
+
+static int runWorker(const char *Path, uint32_t I, uint32_t Shards,
+                     const char *Endpoint) {
+  auto T = openTransport(Endpoint, Shards, false);
+  if (!T)
+    return 1;
+  // A failed scan is still published, so the coordinator stops waiting.
+  ShardSummary S = {I, FailedSummary, 0};
+  bool Ok = scanShard(Path, I, Shards, S);
+  return T->publish(S) && Ok ? 0 : 1;
+}
+
+// Compose the summaries in shard order after checking that together they
+// cover the whole input exactly once.
+static bool combine(Transport &T, size_t N, uint32_t Shards,
+                    std::complex<double> &Alpha, std::complex<double> &Beta) {
+  std::vector<ShardSummary> Summaries;
+  if (!T.collect(Summaries, collectDeadline()))
+    return false;
+  std::vector<uint32_t> Elems(Shards);
+  for (uint32_t I = 0; I < Shards; ++I) {
+    const ShardSummary &S = Summaries[I];
+    size_t Expected = shardStart(N, I + 1, Shards) - shardStart(N, I, Shards);
+    if (S.Summary == FailedSummary) {
+      fprintf(stderr, "Shard %u failed\n", I);
+      return false;
+    }
+    if (S.Gates != Expected) {
+      fprintf(stderr, "Shard %u scanned %llu gates, expected %zu\n", I,
+              static_cast<unsigned long long>(S.Gates), Expected);
+      return false;
+    }
+    Elems[I] = S.Summary;
+  }
+  summary_state(compose_summaries(Elems.data(), Shards), Alpha, Beta);
+  return true;
+}
+
+static void report(std::complex<double> Alpha, std::complex<double> Beta,
+                   std::chrono::duration<double, std::milli> Duration) {
+  printf("Final state: alpha = %.12f + %.12fi, beta = %.12f + %.12fi\n",
+         Alpha.real(), Alpha.imag(), Beta.real(), Beta.imag());
+  printf("Time taken: %.2f ms\n", Duration.count());
+}
+
+// Fork one worker per shard on this machine. Each worker gets an equal share
+// of the OpenMP threads unless OMP_NUM_THREADS says otherwise.
+static int runLocal(const char *Path, uint32_t Shards, const char *Endpoint) {
+  size_t N;
+  if (!readLength(Path, N))
+    return 1;
+  auto T = openTransport(Endpoint, Shards, true);
+  if (!T)
+    return 1;
+  int Threads = getenv("OMP_NUM_THREADS")
+                    ? omp_get_max_threads()
+                    : std::max<int>(1, omp_get_max_threads() / Shards);
+
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  auto start = std::chrono::high_resolution_clock::now();
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+
+  std::vector<pid_t> Pids;
+  bool Ok = true;
+  for (uint32_t I = 0; I < Shards && Ok; ++I) {
+    fflush(stdout);
+    pid_t Pid = fork();
+    if (Pid < 0) {
+      perror("Failed to fork");
+      Ok = false;
+    } else if (Pid == 0) {
+      // Skip the destructors: the transport belongs to the parent.
+      omp_set_num_threads(Threads);
+      _exit(runWorker(Path, I, Shards, Endpoint));
+    } else {
+      Pids.push_back(Pid);
+    }
+  }
+  // Workers publish before they exit, so once all of them have exited every
+  // summary is waiting in the transport.
+  for (pid_t Pid : Pids) {
+    int Status;
+    if (waitpid(Pid, &Status, 0) != Pid || !WIFEXITED(Status) ||
+        WEXITSTATUS(Status) != 0)
+      Ok = false;
+  }
+  if (!Ok) {
+    fprintf(stderr, "A worker failed\n");
+    return 1;
+  }
+
+  std::complex<double> Alpha = {}, Beta = {};
+  if (!combine(*T, N, Shards, Alpha, Beta))
+    return 1;
+
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+
+  report(Alpha, Beta, end - start);
+  return 0;
+}
+
+// Wait for workers started elsewhere, e.g. by a job launcher.
+static int runCoordinator(const char *Path, uint32_t Shards,
+                          const char *Endpoint) {
+  size_t N;
+  if (!readLength(Path, N))
+    return 1;
+  auto T = openTransport(Endpoint, Shards, true);
+  if (!T)
+    return 1;
+
+  auto start = std::chrono::high_resolution_clock::now();
+  std::complex<double> Alpha = {}, Beta = {};
+  if (!combine(*T, N, Shards, Alpha, Beta))
+    return 1;
+  auto end = std::chrono::high_resolution_clock::now();
+
+  report(Alpha, Beta, end - start);
+  return 0;
+}
+
+static bool parseShards(const char *Arg, uint32_t &Shards) {
+  char *End;
+  unsigned long Val = strtoul(Arg, &End, 10);
+  if (*End || Val == 0 || Val >= FailedSummary) {
+    fprintf(stderr, "Invalid shard count: %s\n", Arg);
+    return false;
+  }
+  Shards = Val;
+  return true;
+}
+
+// Split one input file across several processes. Each worker maps and scans
+// its own byte range and publishes the 192-element summary of it; the
+// coordinator composes the summaries in order.
+int main(int argc, char *argv[]) {
+  uint32_t Shards, I;
+  if (argc >= 3 && argc <= 4 && strcmp(argv[1], "worker") != 0 &&
+      strcmp(argv[1], "coordinate") != 0) {
+    if (!parseShards(argv[2], Shards))
+      return 1;
+    std::string Endpoint =
+        argc == 4 ? argv[3] : "shm:/simulate-" + std::to_string(getpid());
+    return runLocal(argv[1], Shards, Endpoint.c_str());
+  }
+  if (argc == 5 && strcmp(argv[1], "coordinate") == 0) {
+    if (!parseShards(argv[3], Shards))
+      return 1;
+    return runCoordinator(argv[2], Shards, argv[4]);
+  }
+  if (argc == 6 && strcmp(argv[1], "worker") == 0) {
+    if (!parseShards(argv[4], Shards))
+      return 1;
+    char *End;
+    I = strtoul(argv[3], &End, 10);
+    if (*End || I >= Shards) {
+      fprintf(stderr, "Invalid shard index: %s\n", argv[3]);
+      return 1;
+    }
+    return runWorker(argv[2], I, Shards, argv[5]);
+  }
+
+  fprintf(stderr,
+          "Usage: %s <input_file> <shards> [endpoint]\n"
+          "       %s coordinate <input_file> <shards> <endpoint>\n"
+          "       %s worker <input_file> <shard> <shards> <endpoint>\n"
+          "Endpoints: shm:/<name> or unix:<path>\n"
+          "SIMULATE_SHARD_TIMEOUT sets how many seconds the coordinator\n"
+          "waits for the workers (default 600).\n",
+          argv[0], argv[0], argv[0]);
+  return 1;
+}
@@ -0,0 +1,81 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+struct QubitGate {
+  char Kind;
+  uint16_t Target, Control;
+};
+
+void simulate_stabilizer(size_t N, const QubitGate *Gates, size_t NumQubits,
+                         uint64_t Seed, uint8_t *Outcomes, uint8_t *Random);
+
+// Set in the header of n-qubit circuits. The header is followed by the number
+// of qubits and then by one QubitGate record per gate.
+static constexpr size_t QubitsFlag = size_t(1) << 62;
+
+int main(int argc, char *argv[]) {
+  if (argc < 2 || argc > 3) {
+    fprintf(stderr, "Usage: %s <input_file> [seed]\n", argv[0]);
+    return 1;
+  }
+  uint64_t Seed = argc == 3 ? strtoull(argv[2], nullptr, 0) : 0;
+
+  FILE *File = fopen(argv[1], "rb");
+  if (!File) {
+    perror("Failed to open file");
+    return 1;
+  }
+  size_t Header, NumQubits;
+  if (fread(&Header, sizeof(size_t), 1, File) != 1 ||
+      !(Header & QubitsFlag) ||
+      fread(&NumQubits, sizeof(size_t), 1, File) != 1 || NumQubits > 65535) {
+    fprintf(stderr, "Invalid input file\n");
+    return 1;
+  }
+  size_t N = Header & ~QubitsFlag;
+  std::vector<QubitGate> Gates(N);
+  if (fread(Gates.data(), sizeof(QubitGate), N, File) != N) {
+    fprintf(stderr, "Failed to read file\n");
+    return 1;
+  }
+  fclose(File);
+  for (auto &G : Gates) {
+    if (G.Target >= NumQubits ||
+        (G.Kind == 'C' && (G.Control >= NumQubits || G.Control == G.Target))) {
+      fprintf(stderr, "Invalid gate\n");
+      return 1;
+    }
+  }
+
+  std::vector<uint8_t> Outcomes(NumQubits), Random(NumQubits);
+
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  auto start = std::chrono::high_resolution_clock::now();
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  simulate_stabilizer(N, Gates.data(), NumQubits, Seed, Outcomes.data(),
+                      Random.data());
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+  auto end = std::chrono::high_resolution_clock::now();
+  std::atomic_signal_fence(std::memory_order_acq_rel);
+
+  // Print at most the first 64 outcomes.
+  std::string Bits;
+  size_t NumRandom = 0;
+  for (size_t Q = 0; Q < NumQubits; ++Q) {
+    NumRandom += Random[Q];
+    if (Q < 64)
+      Bits += '0' + Outcomes[Q];
+  }
+
+  std::chrono::duration<double, std::milli> duration = end - start;
+  printf("Measured: %s%s\n", Bits.c_str(), NumQubits > 64 ? "..." : "");
+  printf("Qubits: %zu, random outcomes: %zu\n", NumQubits, NumRandom);
+  printf("Time taken: %.2f ms\n", duration.count());
+
+  return 0;
+}
@@ -0,0 +1,74 @@
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+void simulate_trajectory(size_t N, const char *Gates, size_t K, uint8_t *Out,
+                         std::complex<double> &Alpha,
+                         std::complex<double> &Beta);
+void trajectory_state(uint8_t Index, std::complex<double> &Alpha,
+                      std::complex<double> &Beta);
+
+// Set in the header of files whose gates are packed three per byte in base 5.
+static constexpr size_t PackedFlag = size_t(1) << 63;
+
+// Records the state after every K-th gate. The output file holds one byte
+// per checkpoint: the index of the state among the 48 reachable ones.
+int main(int argc, char *argv[]) {
+  if (argc < 3 || argc > 4) {
+    fprintf(stderr, "Usage: %s <input_file> <k> [output_file]\n", argv[0]);
+    return 1;
+  }
+  size_t K = atoll(argv[2]);
+  if (K == 0) {
+    fprintf(stderr, "k must be positive\n");
+    return 1;
+  }
+
+  FILE *File = fopen(argv[1], "rb");
+  if (!File) {
+    perror("Failed to open file");
+    return 1;
+  }
+  size_t N;
+  if (fread(&N, sizeof(size_t), 1, File) != 1 || N & PackedFlag) {
+    fprintf(stderr, "Invalid input file\n");
+    return 1;
+  }
+  std::vector<char> Gates(N);
+  if (fread(Gates.data(), 1, N, File) != N) {
+    fprintf(stderr, "Failed to read file\n");
+    return 1;
+  }
+  fclose(File);
+
+  std::vector<uint8_t> Out(N / K);
+  std::complex<double> Alpha = {}, Beta = {};
+  auto start = std::chrono::high_resolution_clock::now();
+  simulate_trajectory(N, Gates.data(), K, Out.data(), Alpha, Beta);
+  auto end = std::chrono::high_resolution_clock::now();
+
+  if (argc == 4) {
+    FILE *OutFile = fopen(argv[3], "wb");
+    if (!OutFile || fwrite(Out.data(), 1, Out.size(), OutFile) != Out.size()) {
+      perror("Failed to write output file");
+      return 1;
+    }
+    fclose(OutFile);
+  }
+
+  std::chrono::duration<double, std::milli> duration = end - start;
+  printf("Final state: alpha = %.12f + %.12fi, beta = %.12f + %.12fi\n",
+         Alpha.real(), Alpha.imag(), Beta.real(), Beta.imag());
+  if (!Out.empty()) {
+    std::complex<double> LastAlpha, LastBeta;
+    trajectory_state(Out.back(), LastAlpha, LastBeta);
+    printf("Checkpoints: %zu, P(0) at the last one: %.6f\n", Out.size(),
+           std::norm(LastAlpha));
+  }
+  printf("Time taken: %.2f ms\n", duration.count());
+
+  return 0;
+}
@@ -0,0 +1,254 @@
+#ifndef GATE_TABLES_H
+#define GATE_TABLES_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "symbolic.h"
+
+// Compile-time derivation of the simulation tables for a gate alphabet, the
+// constexpr counterpart of simulate_map.cpp and the tables in
+// simulate_opt90_gen.py. GateTables<'H', 'X', 'Y', 'Z', 'S'> reproduces
+// their numbering exactly: states are sorted in the order of std::set<Qubit>
+// and group elements are numbered in breadth-first order from the identity.
+//
+// Gate index G always refers to the position of a gate in the alphabet.
+// Fused tables take K gates at once as the base-NumGates number whose most
+// significant digit is the first gate applied.
+
+// A fixed-size table. Plain arrays keep compile-time evaluation fast: GCC
+// evaluates std::array::operator[] as a call on every access.
+template <typename T, size_t N> struct ConstTable {
+  T Data[N];
+  constexpr const T &operator[](size_t I) const { return Data[I]; }
+  constexpr size_t size() const { return N; }
+  constexpr const T *begin() const { return Data; }
+  constexpr const T *end() const { return Data + N; }
+};
+
+template <char... Gates> struct GateTables {
+  static constexpr unsigned NumGates = sizeof...(Gates);
+  static constexpr char Alphabet[NumGates] = {Gates...};
+  static_assert(NumGates > 0, "The alphabet must not be empty");
+
+  // Upper bounds on the number of states and group elements. Exceeding them
+  // fails to compile.
+  static constexpr unsigned MaxStates = 256;
+  static constexpr unsigned MaxElems = 1024;
+
+private:
+  static constexpr void apply(Qubit &Q, char Gate) {
+    switch (Gate) {
+    case 'H':
+      Q.applyH();
+      break;
+    case 'X':
+      Q.applyX();
+      break;
+    case 'Y':
+      Q.applyY();
+      break;
+    case 'Z':
+      Q.applyZ();
+      break;
+    case 'S':
+      Q.applyS();
+      break;
+    default:
+      throw "Unsupported gate";
+    }
+  }
+
+  static constexpr Qubit Zero = {Complex::One(), Complex::Zero()};
+  static constexpr Qubit One = {Complex::Zero(), Complex::One()};
+
+  struct StateSet {
+    unsigned Count = 0;
+    Qubit Items[MaxStates] = {};
+  };
+
+  // Breadth-first search from |0> and |1>, then an insertion sort.
+  static constexpr StateSet findStates() {
+    StateSet Set;
+    auto Insert = [&Set](const Qubit &Q) {
+      for (unsigned I = 0; I < Set.Count; ++I)
+        if (!(Set.Items[I] != Q))
+          return;
+      if (Set.Count == MaxStates)
+        throw "Too many states";
+      Set.Items[Set.Count++] = Q;
+    };
+    Insert(Zero);
+    Insert(One);
+    for (unsigned I = 0; I < Set.Count; ++I) {
+      for (unsigned G = 0; G < NumGates; ++G) {
+        Qubit Q = Set.Items[I];
+        apply(Q, Alphabet[G]);
+        Insert(Q);
+      }
+    }
+    for (unsigned I = 1; I < Set.Count; ++I)
+      for (unsigned J = I; J > 0 && Set.Items[J] < Set.Items[J - 1]; --J) {
+        Qubit Tmp = Set.Items[J];
+        Set.Items[J] = Set.Items[J - 1];
+        Set.Items[J - 1] = Tmp;
+      }
+    return Set;
+  }
+
+  static constexpr StateSet Set = findStates();
+
+  static constexpr unsigned indexOf(const Qubit &Q) {
+    for (unsigned I = 0; I < Set.Count; ++I)
+      if (!(Set.Items[I] != Q))
+        return I;
+    throw "Unknown state";
+  }
+
+public:
+  static constexpr unsigned NumStates = Set.Count;
+  static constexpr uint32_t Base0 = indexOf(Zero);
+  static constexpr uint32_t Base1 = indexOf(One);
+
+  // Alpha and Beta of each state as {Re, Im, Re, Im}.
+  static constexpr auto States = [] {
+    ConstTable<double[4], NumStates> Table = {};
+    for (unsigned I = 0; I < NumStates; ++I) {
+      Table.Data[I][0] = Set.Items[I].Alpha.Real.materialize();
+      Table.Data[I][1] = Set.Items[I].Alpha.Imag.materialize();
+      Table.Data[I][2] = Set.Items[I].Beta.Real.materialize();
+      Table.Data[I][3] = Set.Items[I].Beta.Imag.materialize();
+    }
+    return Table;
+  }();
+
+  // Trans[S][G] is the state reached from state S by gate G.
+  static constexpr auto Trans = [] {
+    ConstTable<uint32_t[NumGates], NumStates> Table = {};
+    for (unsigned I = 0; I < NumStates; ++I)
+      for (unsigned G = 0; G < NumGates; ++G) {
+        Qubit Q = Set.Items[I];
+        apply(Q, Alphabet[G]);
+        Table.Data[I][G] = indexOf(Q);
+      }
+    return Table;
+  }();
+
+  // Trans indexed directly by the gate character, with states premultiplied
+  // by 128: Trans128[S << 7 | Gate] == Trans[S][G] << 7.
+  static constexpr auto Trans128 = [] {
+    ConstTable<uint32_t, NumStates * 128> Table = {};
+    for (unsigned I = 0; I < NumStates; ++I)
+      for (unsigned G = 0; G < NumGates; ++G)
+        Table.Data[I << 7 | static_cast<unsigned char>(Alphabet[G])] =
+            Trans.Data[I][G] << 7;
+    return Table;
+  }();
+
+  static constexpr size_t power(unsigned K) {
+    return K == 0 ? 1 : NumGates * power(K - 1);
+  }
+
+  // Fused<K>[S][Op] applies the K gates encoded by Op to state S.
+  template <unsigned K>
+  static constexpr auto Fused = [] {
+    ConstTable<uint32_t[power(K)], NumStates> Table = {};
+    for (unsigned I = 0; I < NumStates; ++I)
+      for (size_t Op = 0; Op < power(K); ++Op) {
+        uint32_t S = I;
+        for (size_t Div = power(K); Div > 1; Div /= NumGates)
+          S = Trans.Data[S][Op % Div / (Div / NumGates)];
+        Table.Data[I][Op] = S;
+      }
+    return Table;
+  }();
+
+private:
+  // The matrix group generated by the alphabet. Each element is identified
+  // by the states of its two columns (the images of |0> and |1>).
+  struct ElemSet {
+    unsigned Count = 0;
+    uint32_t Columns[MaxElems][2] = {};
+    uint32_t Step[MaxElems][NumGates] = {};
+    // Every element is reached from Parent by one Gate.
+    uint32_t Parent[MaxElems] = {}, Gate[MaxElems] = {};
+  };
+
+  static constexpr ElemSet findElems() {
+    ElemSet Set;
+    Set.Columns[0][0] = Base0;
+    Set.Columns[0][1] = Base1;
+    Set.Count = 1;
+    for (unsigned I = 0; I < Set.Count; ++I) {
+      for (unsigned G = 0; G < NumGates; ++G) {
+        uint32_t C1 = Trans.Data[Set.Columns[I][0]][G];
+        uint32_t C2 = Trans.Data[Set.Columns[I][1]][G];
+        unsigned J = 0;
+        while (J < Set.Count &&
+               (Set.Columns[J][0] != C1 || Set.Columns[J][1] != C2))
+          ++J;
+        if (J == Set.Count) {
+          if (J == MaxElems)
+            throw "Too many group elements";
+          Set.Columns[J][0] = C1;
+          Set.Columns[J][1] = C2;
+          Set.Parent[J] = I;
+          Set.Gate[J] = G;
+          ++Set.Count;
+        }
+        Set.Step[I][G] = J;
+      }
+    }
+    return Set;
+  }
+
+  static constexpr ElemSet Elems = findElems();
+
+public:
+  static constexpr unsigned NumElems = Elems.Count;
+  // Element 0 is the identity matrix.
+  static constexpr uint32_t Identity = 0;
+
+  static constexpr auto Columns = [] {
+    ConstTable<uint32_t[2], NumElems> Table = {};
+    for (unsigned I = 0; I < NumElems; ++I)
+      for (unsigned C = 0; C < 2; ++C)
+        Table.Data[I][C] = Elems.Columns[I][C];
+    return Table;
+  }();
+
+  // Step[E][G] is the element obtained by applying gate G after E.
+  static constexpr auto Step = [] {
+    ConstTable<uint32_t[NumGates], NumElems> Table = {};
+    for (unsigned I = 0; I < NumElems; ++I)
+      for (unsigned G = 0; G < NumGates; ++G)
+        Table.Data[I][G] = Elems.Step[I][G];
+    return Table;
+  }();
+
+  // Step indexed directly by the gate character, with elements premultiplied
+  // by 128: Step128[E << 7 | Gate] == Step[E][G] << 7.
+  static constexpr auto Step128 = [] {
+    ConstTable<uint32_t, NumElems * 128> Table = {};
+    for (unsigned I = 0; I < NumElems; ++I)
+      for (unsigned G = 0; G < NumGates; ++G)
+        Table.Data[I << 7 | static_cast<unsigned char>(Alphabet[G])] =
+            Elems.Step[I][G] << 7;
+    return Table;
+  }();
+
+  // Compose[A][B] is the matrix obtained by applying A first and then B.
+  // B is its parent followed by one gate, and parents precede children.
+  static constexpr auto Compose = [] {
+    ConstTable<uint32_t[NumElems], NumElems> Table = {};
+    for (unsigned A = 0; A < NumElems; ++A) {
+      Table.Data[A][Identity] = A;
+      for (unsigned B = 1; B < NumElems; ++B)
+        Table.Data[A][B] =
+            Elems.Step[Table.Data[A][Elems.Parent[B]]][Elems.Gate[B]];
+    }
+    return Table;
+  }();
+};
+
+#endif // GATE_TABLES_H
@@ -1,32 +1,219 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <omp.h>
 #include <random>
+#include <thread>
+#include <unistd.h>
 #include <vector>
 
+#include "philox.h"
+
+// Set in the header of files whose gates are packed three per byte in base 5.
+static constexpr size_t PackedFlag = size_t(1) << 63;
+// Set in the header of n-qubit circuits. The header is followed by the number
+// of qubits and then by one QubitGate record per gate.
+static constexpr size_t QubitsFlag = size_t(1) << 62;
+// Set in the header of rotation circuits, whose gates are RotationGate
+// records.
+static constexpr size_t RotationFlag = size_t(1) << 61;
+
+// Kind is one of "HXYZS" for a single-qubit gate on Target, or 'C' for a
+// CNOT flipping Target when Control is set.
+struct QubitGate {
+  char Kind;
+  uint16_t Target, Control;
+};
+
+// Axis is 'X', 'Y' or 'Z' for a rotation by Theta radians.
+struct RotationGate {
+  char Axis;
+  double Theta;
+};
+
+// Gates generated and written per chunk. A multiple of 3 * 64 so that every
+// chunk but the last fills whole packed bytes and whole Philox batches.
+static constexpr size_t ChunkGates = size_t(3) << 24;
+// Rotation records are 16 bytes, so their chunks hold fewer gates.
+static constexpr size_t RotationChunkGates = ChunkGates / sizeof(RotationGate);
+
+static bool writeAll(int Fd, const void *Data, size_t Size) {
+  const char *Ptr = static_cast<const char *>(Data);
+  while (Size) {
+    ssize_t Res = write(Fd, Ptr, Size);
+    if (Res <= 0)
+      return false;
+    Ptr += Res;
+    Size -= Res;
+  }
+  return true;
+}
+
+// Write the file bytes for gates [Begin, End) of the stream to Out, with
+// every thread generating its own slice.
+static void fillChunk(uint64_t Seed, size_t Begin, size_t End, bool Packed,
+                      char *Out) {
+  size_t NumGroups = (End - Begin + 191) / 192;
+#pragma omp parallel
+  {
+    int I = omp_get_thread_num();
+    int NumThreads = omp_get_num_threads();
+    size_t Start = Begin + NumGroups * I / NumThreads * 192;
+    size_t Stop =
+        std::min(End, Begin + NumGroups * (I + 1) / NumThreads * 192);
+    if (!Packed) {
+      if (Start < Stop)
+        philoxGates(Seed, Start, Stop - Start, Out + (Start - Begin));
+    } else {
+      // Byte J holds gates 3J, 3J+1 and 3J+2 as G0 * 25 + G1 * 5 + G2. A
+      // trailing partial byte keeps its gates in the high digits.
+      char Digits[3 * 1024 + 2];
+      for (size_t S = Start; S < Stop; S += 3 * 1024) {
+        size_t Len = std::min<size_t>(3 * 1024, Stop - S);
+        philoxGates(Seed, S, Len, Digits, "\0\1\2\3\4");
+        Digits[Len] = Digits[Len + 1] = 0;
+        char *Bytes = Out + (S - Begin) / 3;
+        for (size_t J = 0; J < Len; J += 3)
+          Bytes[J / 3] = Digits[J] * 25 + Digits[J + 1] * 5 + Digits[J + 2];
+      }
+    }
+  }
+}
+
+// Write the records for rotations [Begin, End) of the stream to Out, with
+// every thread generating its own slice. Axes and angles are uniform, the
+// angles in [-pi, pi).
+static void fillRotations(uint64_t Seed, size_t Begin, size_t End,
+                          RotationGate *Out) {
+#pragma omp parallel
+  {
+    int I = omp_get_thread_num();
+    int NumThreads = omp_get_num_threads();
+    size_t Start = Begin + (End - Begin) * I / NumThreads;
+    size_t Stop = Begin + (End - Begin) * (I + 1) / NumThreads;
+    uint8_t Axes[1024];
+    double Angles[1024];
+    for (size_t S = Start; S < Stop; S += 1024) {
+      size_t Len = std::min<size_t>(1024, Stop - S);
+      philoxRotations(Seed, S, Len, Axes, Angles);
+      RotationGate *Gates = Out + (S - Begin);
+      // Zero the padding so that the file depends on the seed alone.
+      memset(static_cast<void *>(Gates), 0, Len * sizeof(RotationGate));
+      for (size_t J = 0; J < Len; ++J) {
+        Gates[J].Axis = "XYZ"[Axes[J]];
+        Gates[J].Theta = Angles[J];
+      }
+    }
+  }
+}
+
 int main(int argc, char *argv[]) {
-  if (argc != 3) {
-    fprintf(stderr, "Usage: %s <number_of_gates> <output_file>\n", argv[0]);
+  bool Packed = false, Qubits = false, Rotations = false, BadArgs = argc < 3;
+  size_t NumQubits = 0;
+  bool HasSeed = false;
+  uint64_t Seed = 0;
+  for (int I = 3; I < argc; ++I) {
+    if (strcmp(argv[I], "packed") == 0)
+      Packed = true;
+    else if (strcmp(argv[I], "rotations") == 0)
+      Rotations = true;
+    else if (strncmp(argv[I], "qubits=", 7) == 0)
+      Qubits = true, NumQubits = atoll(argv[I] + 7);
+    else if (strncmp(argv[I], "seed=", 5) == 0)
+      HasSeed = true, Seed = strtoull(argv[I] + 5, nullptr, 0);
+    else
+      BadArgs = true;
+  }
+  if (BadArgs || Packed + Qubits + Rotations > 1) {
+    fprintf(stderr,
+            "Usage: %s <number_of_gates> <output_file> "
+            "[packed | qubits=<n> | rotations] [seed=<s>]\n",
+            argv[0]);
     return 1;
   }
-
-  std::random_device rd;
-  std::mt19937 gen(rd());
-  std::uniform_int_distribution<> dis(0, 4);
-  size_t N = atoll(argv[1]);
-  std::vector<char> Gates(N);
-  for (size_t i = 0; i < N; ++i) {
-    int gate = dis(gen);
-    Gates[i] = "HXYZS"[gate];
+  if (Qubits && (NumQubits < 2 || NumQubits > 65535)) {
+    fprintf(stderr, "The number of qubits must be between 2 and 65535\n");
+    return 1;
   }
+  // The same seed always yields the same file, whatever the thread count.
+  if (!HasSeed)
+    Seed = (uint64_t(std::random_device()()) << 32) | std::random_device()();
+  size_t N = atoll(argv[1]);
 
-  FILE *File = fopen(argv[2], "wb");
-  if (!File) {
+  int Fd = open(argv[2], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (Fd < 0) {
     perror("Failed to open file");
     return 1;
   }
+  size_t Header = Packed      ? N | PackedFlag
+                  : NumQubits ? N | QubitsFlag
+                  : Rotations ? N | RotationFlag
+                              : N;
+  if (!writeAll(Fd, &Header, sizeof(Header)) ||
+      (NumQubits && !writeAll(Fd, &NumQubits, sizeof(NumQubits)))) {
+    perror("Failed to write file");
+    return 1;
+  }
+
+  if (NumQubits) {
+    // One gate in six is a CNOT between two distinct random qubits.
+    std::mt19937_64 Rng(Seed);
+    std::uniform_int_distribution<size_t> Qubit(0, NumQubits - 1);
+    std::vector<QubitGate> Gates(N);
+    memset(Gates.data(), 0, N * sizeof(QubitGate));
+    for (auto &G : Gates) {
+      uint16_t Target = Qubit(Rng), Control = Qubit(Rng);
+      bool Cnot = Rng() % 6 == 0 && Control != Target;
+      G.Kind = Cnot ? 'C' : "HXYZS"[Rng() % 5];
+      G.Target = Target;
+      G.Control = Cnot ? Control : 0;
+    }
+    if (!writeAll(Fd, Gates.data(), N * sizeof(QubitGate))) {
+      perror("Failed to write file");
+      return 1;
+    }
+    close(Fd);
+    return 0;
+  }
 
-  fwrite(&N, sizeof(size_t), 1, File);
-  fwrite(Gates.data(), sizeof(char), N, File);
-  fclose(File);
+  // Generate chunk K + 1 on all threads while a writer thread streams chunk
+  // K to the file from a 2 MiB aligned buffer.
+  constexpr size_t Align = size_t(2) << 20;
+  size_t StepGates = Rotations ? RotationChunkGates : ChunkGates;
+  size_t BufferSize = (ChunkGates + Align - 1) / Align * Align;
+  char *Buffers[2] = {static_cast<char *>(aligned_alloc(Align, BufferSize)),
+                      static_cast<char *>(aligned_alloc(Align, BufferSize))};
+  std::atomic<bool> WriteFailed{false};
+  std::thread Writer;
+  for (size_t Begin = 0, K = 0; Begin < N; Begin += StepGates, ++K) {
+    size_t End = std::min(N, Begin + StepGates);
+    char *Buffer = Buffers[K % 2];
+    if (Rotations)
+      fillRotations(Seed, Begin, End, reinterpret_cast<RotationGate *>(Buffer));
+    else
+      fillChunk(Seed, Begin, End, Packed, Buffer);
+    if (Writer.joinable())
+      Writer.join();
+    size_t Bytes = Rotations ? (End - Begin) * sizeof(RotationGate)
+                   : Packed  ? (End - Begin + 2) / 3
+                             : End - Begin;
+    Writer = std::thread([=, &WriteFailed] {
+      if (!writeAll(Fd, Buffer, Bytes))
+        WriteFailed = true;
+    });
+  }
+  if (Writer.joinable())
+    Writer.join();
+  free(Buffers[0]);
+  free(Buffers[1]);
+  if (WriteFailed || close(Fd) != 0) {
+    perror("Failed to write file");
+    return 1;
+  }
 
   return 0;
 }
@@ -0,0 +1,170 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel random
+// numbers: as easy as 1, 2, 3", SC'11). Gate I of the stream for a seed is
+// derived from word I % 4 of the block for counter I / 4, so any range of
+// gates can be generated independently and the output does not depend on
+// how the range is split between threads.
+
+static constexpr uint32_t PhiloxM0 = 0xD2511F53, PhiloxM1 = 0xCD9E8D57;
+static constexpr uint32_t PhiloxW0 = 0x9E3779B9, PhiloxW1 = 0xBB67AE85;
+
+// Generate the blocks for Lanes consecutive counters starting at Counter.
+// Kept as plain loops over lanes so that they vectorize.
+template <unsigned Lanes>
+static inline void philoxBlocks(uint64_t Seed, uint64_t Counter,
+                                uint32_t Out[4][Lanes]) {
+  uint32_t X0[Lanes], X1[Lanes], X2[Lanes], X3[Lanes];
+  for (unsigned L = 0; L < Lanes; ++L) {
+    X0[L] = static_cast<uint32_t>(Counter + L);
+    X1[L] = static_cast<uint32_t>((Counter + L) >> 32);
+    X2[L] = 0;
+    X3[L] = 0;
+  }
+  uint32_t K0 = static_cast<uint32_t>(Seed);
+  uint32_t K1 = static_cast<uint32_t>(Seed >> 32);
+  for (int Round = 0; Round < 10; ++Round) {
+    for (unsigned L = 0; L < Lanes; ++L) {
+      uint64_t P0 = uint64_t(PhiloxM0) * X0[L];
+      uint64_t P1 = uint64_t(PhiloxM1) * X2[L];
+      uint32_t Y0 = static_cast<uint32_t>(P1 >> 32) ^ X1[L] ^ K0;
+      uint32_t Y1 = static_cast<uint32_t>(P1);
+      uint32_t Y2 = static_cast<uint32_t>(P0 >> 32) ^ X3[L] ^ K1;
+      uint32_t Y3 = static_cast<uint32_t>(P0);
+      X0[L] = Y0;
+      X1[L] = Y1;
+      X2[L] = Y2;
+      X3[L] = Y3;
+    }
+    K0 += PhiloxW0;
+    K1 += PhiloxW1;
+  }
+  for (unsigned L = 0; L < Lanes; ++L) {
+    Out[0][L] = X0[L];
+    Out[1][L] = X1[L];
+    Out[2][L] = X2[L];
+    Out[3][L] = X3[L];
+  }
+}
+
+// Map a uniform 32-bit word to 0..4 by multiply-shift.
+static inline uint32_t philoxDigit(uint32_t Word) {
+  return static_cast<uint32_t>((uint64_t(Word) * 5) >> 32);
+}
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+// Full 64-bit products of the 32-bit lanes of X with M, as the low and high
+// halves.
+static inline void philoxMul(__m512i X, __m512i M, __m512i &Lo, __m512i &Hi) {
+  __m512i Even = _mm512_mul_epu32(X, M);
+  __m512i Odd = _mm512_mul_epu32(_mm512_srli_epi64(X, 32), M);
+  Lo = _mm512_mask_blend_epi32(0xAAAA, Even, _mm512_slli_epi64(Odd, 32));
+  Hi = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(Even, 32), Odd);
+}
+
+// 64 gates from the blocks of 16 consecutive counters, one counter per lane.
+static inline void philoxGates64(uint64_t Seed, uint64_t Counter, char *Out,
+                                 __m512i Symbols) {
+  const __m512i Lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+                                         12, 13, 14, 15);
+  __m512i Base = _mm512_set1_epi32(static_cast<uint32_t>(Counter));
+  __m512i X0 = _mm512_add_epi32(Base, Lane);
+  __m512i X1 = _mm512_mask_add_epi32(
+      _mm512_set1_epi32(static_cast<uint32_t>(Counter >> 32)),
+      _mm512_cmplt_epu32_mask(X0, Base),
+      _mm512_set1_epi32(static_cast<uint32_t>(Counter >> 32)),
+      _mm512_set1_epi32(1));
+  __m512i X2 = _mm512_setzero_si512(), X3 = _mm512_setzero_si512();
+  const __m512i M0 = _mm512_set1_epi32(PhiloxM0);
+  const __m512i M1 = _mm512_set1_epi32(PhiloxM1);
+  uint32_t K0 = static_cast<uint32_t>(Seed);
+  uint32_t K1 = static_cast<uint32_t>(Seed >> 32);
+  for (int Round = 0; Round < 10; ++Round) {
+    __m512i Lo0, Hi0, Lo1, Hi1;
+    philoxMul(X0, M0, Lo0, Hi0);
+    philoxMul(X2, M1, Lo1, Hi1);
+    X0 = _mm512_xor_si512(_mm512_xor_si512(Hi1, X1), _mm512_set1_epi32(K0));
+    X1 = Lo1;
+    X2 = _mm512_xor_si512(_mm512_xor_si512(Hi0, X3), _mm512_set1_epi32(K1));
+    X3 = Lo0;
+    K0 += PhiloxW0;
+    K1 += PhiloxW1;
+  }
+
+  // Word W of lane L becomes byte 4L + W, then the digits index Symbols.
+  const __m512i Five = _mm512_set1_epi32(5);
+  __m512i Digits[4], Unused;
+  philoxMul(X0, Five, Unused, Digits[0]);
+  philoxMul(X1, Five, Unused, Digits[1]);
+  philoxMul(X2, Five, Unused, Digits[2]);
+  philoxMul(X3, Five, Unused, Digits[3]);
+  __m512i Bytes = _mm512_or_si512(
+      _mm512_or_si512(Digits[0], _mm512_slli_epi32(Digits[1], 8)),
+      _mm512_or_si512(_mm512_slli_epi32(Digits[2], 16),
+                      _mm512_slli_epi32(Digits[3], 24)));
+  _mm512_storeu_si512(Out, _mm512_shuffle_epi8(Symbols, Bytes));
+}
+#endif
+
+// Write Symbols[G] for gates Offset .. Offset + Count - 1 of the stream,
+// where G in 0..4 is the gate's index in "HXYZS".
+static inline void philoxGates(uint64_t Seed, size_t Offset, size_t Count,
+                               char *Out, const char *Symbols = "HXYZS") {
+  constexpr unsigned Lanes = 16;
+  size_t I = 0;
+  // Gates up to the next block boundary, one block at a time.
+  while (I < Count && (Offset + I) % (4 * Lanes) != 0) {
+    uint32_t Block[4][1];
+    philoxBlocks<1>(Seed, (Offset + I) / 4, Block);
+    Out[I] = Symbols[philoxDigit(Block[(Offset + I) % 4][0])];
+    ++I;
+  }
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+  char Table[16] = {};
+  memcpy(Table, Symbols, 5);
+  __m512i SymbolsVec = _mm512_broadcast_i32x4(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(Table)));
+  for (; I + 4 * Lanes <= Count; I += 4 * Lanes)
+    philoxGates64(Seed, (Offset + I) / 4, Out + I, SymbolsVec);
+#else
+  for (; I + 4 * Lanes <= Count; I += 4 * Lanes) {
+    uint32_t Block[4][Lanes];
+    philoxBlocks<Lanes>(Seed, (Offset + I) / 4, Block);
+    for (unsigned L = 0; L < Lanes; ++L)
+      for (unsigned W = 0; W < 4; ++W)
+        Out[I + 4 * L + W] = Symbols[philoxDigit(Block[W][L])];
+  }
+#endif
+  for (; I < Count; ++I) {
+    uint32_t Block[4][1];
+    philoxBlocks<1>(Seed, (Offset + I) / 4, Block);
+    Out[I] = Symbols[philoxDigit(Block[(Offset + I) % 4][0])];
+  }
+}
+
+// Rotation I of the stream for a seed uses the whole block for counter I:
+// word 0 picks the axis and words 2 and 3 give a 53-bit fraction for the
+// angle. Writes Axes[I] in 0..2 and Angles[I] in [-pi, pi) for rotations
+// Offset .. Offset + Count - 1.
+static inline void philoxRotations(uint64_t Seed, size_t Offset, size_t Count,
+                                   uint8_t *Axes, double *Angles) {
+  constexpr unsigned Lanes = 16;
+  for (size_t I = 0; I < Count; I += Lanes) {
+    uint32_t Block[4][Lanes];
+    philoxBlocks<Lanes>(Seed, Offset + I, Block);
+    for (unsigned L = 0; L < Lanes && I + L < Count; ++L) {
+      uint64_t Bits = uint64_t(Block[2][L]) << 32 | Block[3][L];
+      Axes[I + L] = static_cast<uint8_t>((uint64_t(Block[0][L]) * 3) >> 32);
+      Angles[I + L] = (double(Bits >> 11) * 0x1p-52 - 1.0) * M_PI;
+    }
+  }
+}
+
+#endif // PHILOX_H
@@ -0,0 +1,285 @@
+#ifndef SHARD_TRANSPORT_H
+#define SHARD_TRANSPORT_H
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <poll.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+// Moves the chunk summaries of sharded runs from the workers to the
+// coordinator. Every worker publishes exactly one summary; the coordinator
+// collects one from every shard and composes them in shard order.
+//
+// A transport is named by an endpoint "<scheme>:<address>":
+//   shm:<name>    a POSIX shared memory object, for workers on this machine
+//   unix:<path>   a Unix domain socket, for workers on this machine
+// Transports that cross machines plug in as further schemes in
+// openTransport.
+
+// What a worker reports for shard Shard: the matrix of its Gates gates, or
+// FailedSummary if it could not scan them.
+struct ShardSummary {
+  uint32_t Shard;
+  uint32_t Summary;
+  uint64_t Gates;
+};
+
+static constexpr uint32_t FailedSummary = UINT32_MAX;
+
+using Deadline = std::chrono::steady_clock::time_point;
+
+class Transport {
+public:
+  virtual ~Transport() = default;
+  // Worker side.
+  virtual bool publish(const ShardSummary &S) = 0;
+  // Coordinator side: wait until every shard has published and store the
+  // summary of shard I in Out[I]. A worker that dies before publishing
+  // never shows up, so give up at Until.
+  virtual bool collect(std::vector<ShardSummary> &Out, Deadline Until) = 0;
+};
+
+// One slot per shard in a shared memory object. The worker writes its slot
+// and then releases Ready; the coordinator polls the flags.
+class ShmTransport : public Transport {
+  struct Slot {
+    std::atomic<uint32_t> Ready;
+    ShardSummary Summary;
+  };
+  static_assert(std::atomic<uint32_t>::is_always_lock_free,
+                "Slots are shared between processes");
+
+  std::string Name;
+  uint32_t Shards;
+  bool Owner;
+  Slot *Slots = nullptr;
+
+  size_t size() const { return sizeof(Slot) * Shards; }
+
+public:
+  ShmTransport(const char *Name, uint32_t Shards, bool Owner)
+      : Name(Name), Shards(Shards), Owner(Owner) {}
+  ~ShmTransport() override {
+    if (Slots)
+      munmap(Slots, size());
+    if (Owner)
+      shm_unlink(Name.c_str());
+  }
+
+  // The coordinator creates the object; workers must start after it.
+  bool open() {
+    int Fd = Owner ? shm_open(Name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600)
+                   : shm_open(Name.c_str(), O_RDWR, 0);
+    if (Fd < 0) {
+      perror("Failed to open shared memory");
+      Owner = false;
+      return false;
+    }
+    if (Owner && ftruncate(Fd, size()) != 0) {
+      perror("Failed to size shared memory");
+      close(Fd);
+      return false;
+    }
+    struct stat Stat;
+    if (fstat(Fd, &Stat) != 0 || size_t(Stat.st_size) != size()) {
+      fprintf(stderr, "Shared memory does not match %u shards\n", Shards);
+      close(Fd);
+      return false;
+    }
+    void *Map =
+        mmap(nullptr, size(), PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+    close(Fd);
+    if (Map == MAP_FAILED) {
+      perror("Failed to map shared memory");
+      return false;
+    }
+    // A fresh object is zero-filled, so every Ready flag starts cleared.
+    Slots = static_cast<Slot *>(Map);
+    return true;
+  }
+
+  bool publish(const ShardSummary &S) override {
+    if (S.Shard >= Shards)
+      return false;
+    Slots[S.Shard].Summary = S;
+    Slots[S.Shard].Ready.store(1, std::memory_order_release);
+    return true;
+  }
+
+  bool collect(std::vector<ShardSummary> &Out, Deadline Until) override {
+    Out.resize(Shards);
+    for (uint32_t I = 0; I < Shards; ++I) {
+      // Summaries arrive once per run, so a short sleep costs nothing.
+      while (!Slots[I].Ready.load(std::memory_order_acquire)) {
+        if (std::chrono::steady_clock::now() >= Until) {
+          fprintf(stderr, "Timed out waiting for shard %u\n", I);
+          return false;
+        }
+        timespec Delay = {0, 100000};
+        nanosleep(&Delay, nullptr);
+      }
+      Out[I] = Slots[I].Summary;
+    }
+    return true;
+  }
+};
+
+// Each worker connects, sends its summary as one fixed-size message and
+// disconnects. The coordinator accepts one connection per shard.
+class UnixSocketTransport : public Transport {
+  std::string Path;
+  uint32_t Shards;
+  bool Owner;
+  int Fd = -1;
+
+  bool address(sockaddr_un &Addr) const {
+    Addr = {};
+    Addr.sun_family = AF_UNIX;
+    if (Path.size() >= sizeof(Addr.sun_path)) {
+      fprintf(stderr, "Socket path too long: %s\n", Path.c_str());
+      return false;
+    }
+    memcpy(Addr.sun_path, Path.c_str(), Path.size() + 1);
+    return true;
+  }
+
+  static bool transfer(int Fd, void *Data, size_t Size, bool Send) {
+    char *Ptr = static_cast<char *>(Data);
+    while (Size) {
+      ssize_t Res = Send ? write(Fd, Ptr, Size) : read(Fd, Ptr, Size);
+      if (Res < 0 && errno == EINTR)
+        continue;
+      if (Res <= 0)
+        return false;
+      Ptr += Res;
+      Size -= Res;
+    }
+    return true;
+  }
+
+public:
+  UnixSocketTransport(const char *Path, uint32_t Shards, bool Owner)
+      : Path(Path), Shards(Shards), Owner(Owner) {}
+  ~UnixSocketTransport() override {
+    if (Fd >= 0)
+      close(Fd);
+    if (Owner)
+      unlink(Path.c_str());
+  }
+
+  // The coordinator listens before any worker starts. Workers connect when
+  // they publish.
+  bool open() {
+    if (!Owner)
+      return true;
+    sockaddr_un Addr;
+    if (!address(Addr))
+      return false;
+    Fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (Fd < 0 || bind(Fd, reinterpret_cast<sockaddr *>(&Addr),
+                       sizeof(Addr)) != 0) {
+      perror("Failed to bind socket");
+      Owner = false;
+      return false;
+    }
+    if (listen(Fd, Shards) != 0) {
+      perror("Failed to listen on socket");
+      return false;
+    }
+    return true;
+  }
+
+  // Workers launched by hand may start before the coordinator; retry for up
+  // to a minute.
+  bool publish(const ShardSummary &S) override {
+    sockaddr_un Addr;
+    if (!address(Addr))
+      return false;
+    for (int Attempt = 0; Attempt < 600; ++Attempt) {
+      int Conn = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (Conn < 0)
+        break;
+      if (connect(Conn, reinterpret_cast<sockaddr *>(&Addr), sizeof(Addr)) ==
+          0) {
+        ShardSummary Msg = S;
+        bool Ok = transfer(Conn, &Msg, sizeof(Msg), true);
+        close(Conn);
+        return Ok;
+      }
+      close(Conn);
+      timespec Delay = {0, 100000000};
+      nanosleep(&Delay, nullptr);
+    }
+    perror("Failed to connect to coordinator");
+    return false;
+  }
+
+  bool collect(std::vector<ShardSummary> &Out, Deadline Until) override {
+    Out.assign(Shards, {});
+    std::vector<bool> Seen(Shards);
+    for (uint32_t Received = 0; Received < Shards;) {
+      auto Left = std::chrono::duration_cast<std::chrono::milliseconds>(
+          Until - std::chrono::steady_clock::now());
+      pollfd Listen = {Fd, POLLIN, 0};
+      int Ready = Left.count() > 0 ? poll(&Listen, 1, Left.count()) : 0;
+      if (Ready < 0 && errno == EINTR)
+        continue;
+      if (Ready <= 0) {
+        fprintf(stderr, "Timed out waiting for %u of %u shards\n",
+                Shards - Received, Shards);
+        return false;
+      }
+      int Conn = accept(Fd, nullptr, nullptr);
+      if (Conn < 0) {
+        if (errno == EINTR)
+          continue;
+        perror("Failed to accept worker");
+        return false;
+      }
+      ShardSummary Msg;
+      bool Ok = transfer(Conn, &Msg, sizeof(Msg), false);
+      close(Conn);
+      if (!Ok || Msg.Shard >= Shards || Seen[Msg.Shard]) {
+        fprintf(stderr, "Malformed summary from worker\n");
+        return false;
+      }
+      Seen[Msg.Shard] = true;
+      Out[Msg.Shard] = Msg;
+      ++Received;
+    }
+    return true;
+  }
+};
+
+// Opens the transport named by Endpoint for Shards shards. The coordinator
+// (Owner) creates it and removes it again when done.
+static inline std::unique_ptr<Transport>
+openTransport(const char *Endpoint, uint32_t Shards, bool Owner) {
+  if (strncmp(Endpoint, "shm:", 4) == 0) {
+    auto T = std::make_unique<ShmTransport>(Endpoint + 4, Shards, Owner);
+    if (T->open())
+      return T;
+  } else if (strncmp(Endpoint, "unix:", 5) == 0) {
+    auto T = std::make_unique<UnixSocketTransport>(Endpoint + 5, Shards, Owner);
+    if (T->open())
+      return T;
+  } else {
+    fprintf(stderr, "Unknown transport: %s\n", Endpoint);
+  }
+  return nullptr;
+}
+
+#endif // SHARD_TRANSPORT_H
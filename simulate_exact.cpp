@@ -0,0 +1,398 @@
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+#include <omp.h>
+#include <vector>
+
+// Exact simulation of Clifford+T circuits ("HXYZST") over the ring
+// Z[1/sqrt(2), i]. Every entry of a product of these gates is
+// (a + b w + c w^2 + d w^3) / sqrt(2)^K with w = e^{i pi/4} and integers
+// a, b, c, d, so a matrix is 16 int64 coefficients and one shared exponent
+// K. The gates only permute and negate coefficients, except H which adds
+// rows and increments K, so a gate costs a few vector permutes and adds.
+//
+// Without T the reachable entries are finite, so the coefficients stay
+// small forever. With T the minimal K can grow without bound and the
+// coefficients grow like sqrt(2)^K, so circuits with many T gates
+// eventually exceed int64.
+// Such chunks are detected and recomputed in double precision.
+
+// Coefficient J of entry (Row, Col) is Coef[Row * 8 + Col * 4 + J], so each
+// row fills one 512-bit register.
+struct RingMatrix {
+  alignas(64) int64_t Coef[16];
+  int64_t K;
+};
+
+// Coefficients of magnitude at most 2^60 survive the sum of two rows and
+// the reduction below without overflow.
+static constexpr int64_t MaxCoef = int64_t(1) << 60;
+
+// A gate or reduction as a map on the 16 lanes: new lane L is the sum over
+// terms T of Sign[T][L] * Old[Src[T][L]], where a zero sign drops the term,
+// and K grows by DK.
+struct LaneOp {
+  int64_t Src[2][16];
+  int64_t Sign[2][16];
+  int64_t DK;
+};
+
+// Entry (R, S) of a gate is w^Power[R][S], or 0 for -1, over sqrt(2)^DK.
+static LaneOp gateOp(const int (&Power)[2][2], int64_t DK) {
+  LaneOp Op = {};
+  for (int L = 0; L < 16; ++L) {
+    int Row = L / 8, Col = L / 4 % 2, J = L % 4;
+    for (int S = 0; S < 2; ++S) {
+      int M = Power[Row][S];
+      if (M < 0)
+        continue;
+      // w^M * w^I lands on w^J, negated when it wraps past w^4 = -1.
+      int I = ((J - M) % 4 + 4) % 4;
+      Op.Src[S][L] = S * 8 + Col * 4 + I;
+      Op.Sign[S][L] = (I + M) % 8 >= 4 ? -1 : 1;
+    }
+  }
+  Op.DK = DK;
+  return Op;
+}
+
+// x / sqrt(2) = x (w - w^3) / 2 maps (a, b, c, d) to
+// ((b - d) / 2, (a + c) / 2, (b + d) / 2, (c - a) / 2). The halving is left
+// to the caller.
+static LaneOp reduceOp() {
+  static constexpr int64_t Src[2][4] = {{1, 0, 1, 2}, {3, 2, 3, 0}};
+  static constexpr int64_t Sign[2][4] = {{1, 1, 1, 1}, {-1, 1, 1, -1}};
+  LaneOp Op = {};
+  for (int L = 0; L < 16; ++L)
+    for (int T = 0; T < 2; ++T) {
+      Op.Src[T][L] = (L & ~3) + Src[T][L % 4];
+      Op.Sign[T][L] = Sign[T][L % 4];
+    }
+  Op.DK = -1;
+  return Op;
+}
+
+static const char GateNames[] = "HXYZST";
+static constexpr int NumGates = 6;
+
+static LaneOp GateOps[NumGates];
+static LaneOp ReduceOp;
+static uint8_t GateIndex[256];
+
+static void buildOps() {
+  static constexpr int Powers[NumGates][2][2] = {
+      {{0, 0}, {0, 4}},   // H
+      {{-1, 0}, {0, -1}}, // X
+      {{-1, 6}, {2, -1}}, // Y
+      {{0, -1}, {-1, 4}}, // Z
+      {{0, -1}, {-1, 2}}, // S
+      {{0, -1}, {-1, 1}}, // T
+  };
+  for (int G = 0; G < NumGates; ++G) {
+    GateOps[G] = gateOp(Powers[G], G == 0);
+    GateIndex[static_cast<uint8_t>(GateNames[G])] = G;
+  }
+  ReduceOp = reduceOp();
+}
+
+static void identity(RingMatrix &M) {
+  for (auto &C : M.Coef)
+    C = 0;
+  M.Coef[0] = M.Coef[12] = 1;
+  M.K = 0;
+}
+
+// x is divisible by sqrt(2) in Z[w] iff a = c and b = d modulo 2.
+static bool divisible(const int64_t *X) {
+  return ((X[0] ^ X[2]) & 1) == 0 && ((X[1] ^ X[3]) & 1) == 0;
+}
+
+#if defined(__AVX512F__)
+struct VecOp {
+  __m512i Idx[2][2];
+  __mmask8 Keep[2][2], Neg[2][2];
+  int64_t DK;
+};
+
+static VecOp vectorize(const LaneOp &Op) {
+  VecOp V = {};
+  for (int R = 0; R < 2; ++R)
+    for (int T = 0; T < 2; ++T) {
+      V.Idx[R][T] = _mm512_loadu_si512(Op.Src[T] + R * 8);
+      for (int L = 0; L < 8; ++L) {
+        V.Keep[R][T] |= (Op.Sign[T][R * 8 + L] != 0) << L;
+        V.Neg[R][T] |= (Op.Sign[T][R * 8 + L] < 0) << L;
+      }
+    }
+  V.DK = Op.DK;
+  return V;
+}
+
+static inline __m512i applyRow(const VecOp &Op, int R, __m512i Row0,
+                               __m512i Row1) {
+  const __m512i Zero = _mm512_setzero_si512();
+  __m512i A = _mm512_maskz_permutex2var_epi64(Op.Keep[R][0], Row0,
+                                              Op.Idx[R][0], Row1);
+  __m512i B = _mm512_maskz_permutex2var_epi64(Op.Keep[R][1], Row0,
+                                              Op.Idx[R][1], Row1);
+  A = _mm512_mask_sub_epi64(A, Op.Neg[R][0], Zero, A);
+  B = _mm512_mask_sub_epi64(B, Op.Neg[R][1], Zero, B);
+  return _mm512_add_epi64(A, B);
+}
+
+// Divide by sqrt(2) if every entry allows it and K is positive.
+static inline void reduce(const VecOp &Op, __m512i &Row0, __m512i &Row1,
+                          int64_t &K) {
+  const __m512i One = _mm512_set1_epi64(1);
+  // Swap a with c and b with d to compare their parities.
+  __m512i P0 = _mm512_xor_si512(Row0, _mm512_permutex_epi64(Row0, 0x4E));
+  __m512i P1 = _mm512_xor_si512(Row1, _mm512_permutex_epi64(Row1, 0x4E));
+  bool Cond = _mm512_test_epi64_mask(_mm512_or_si512(P0, P1), One) == 0 &&
+              K > 0;
+  __mmask8 Mask = -static_cast<__mmask8>(Cond);
+  __m512i New0 = _mm512_srai_epi64(applyRow(Op, 0, Row0, Row1), 1);
+  __m512i New1 = _mm512_srai_epi64(applyRow(Op, 1, Row0, Row1), 1);
+  Row0 = _mm512_mask_blend_epi64(Mask, Row0, New0);
+  Row1 = _mm512_mask_blend_epi64(Mask, Row1, New1);
+  K -= Cond;
+}
+
+// Apply Size gates to M. Returns false if a coefficient left the safe range.
+static bool scan(RingMatrix &M, const char *Gates, size_t Size) {
+  VecOp Ops[NumGates];
+  for (int G = 0; G < NumGates; ++G)
+    Ops[G] = vectorize(GateOps[G]);
+  VecOp Reduce = vectorize(ReduceOp);
+
+  __m512i Row0 = _mm512_load_si512(M.Coef);
+  __m512i Row1 = _mm512_load_si512(M.Coef + 8);
+  int64_t K = M.K;
+  // The OR of all magnitudes seen, checked once per block.
+  __m512i Seen = _mm512_setzero_si512();
+  const __m512i Limit = _mm512_set1_epi64(~(MaxCoef - 1));
+  constexpr size_t Block = 4096;
+  for (size_t Begin = 0; Begin < Size; Begin += Block) {
+    size_t End = Begin + Block < Size ? Begin + Block : Size;
+    for (size_t J = Begin; J < End; ++J) {
+      const VecOp &Op = Ops[GateIndex[static_cast<uint8_t>(Gates[J])]];
+      __m512i New0 = applyRow(Op, 0, Row0, Row1);
+      Row1 = applyRow(Op, 1, Row0, Row1);
+      Row0 = New0;
+      K += Op.DK;
+      // An H moves the minimal exponent by at most one while K grows by one,
+      // so two reductions restore the reduced form.
+      reduce(Reduce, Row0, Row1, K);
+      reduce(Reduce, Row0, Row1, K);
+      Seen = _mm512_or_si512(
+          Seen, _mm512_xor_si512(Row0, _mm512_srai_epi64(Row0, 63)));
+      Seen = _mm512_or_si512(
+          Seen, _mm512_xor_si512(Row1, _mm512_srai_epi64(Row1, 63)));
+    }
+    if (_mm512_test_epi64_mask(Seen, Limit))
+      return false;
+  }
+
+  _mm512_store_si512(M.Coef, Row0);
+  _mm512_store_si512(M.Coef + 8, Row1);
+  M.K = K;
+  return true;
+}
+#else
+static void applyOp(const LaneOp &Op, const int64_t *Old, int64_t *New) {
+  for (int L = 0; L < 16; ++L)
+    New[L] = Op.Sign[0][L] * Old[Op.Src[0][L]] +
+             Op.Sign[1][L] * Old[Op.Src[1][L]];
+}
+
+static void reduce(int64_t *Coef, int64_t &K) {
+  bool Cond = K > 0;
+  for (int E = 0; E < 4; ++E)
+    Cond &= divisible(Coef + E * 4);
+  int64_t New[16];
+  applyOp(ReduceOp, Coef, New);
+  for (int L = 0; L < 16; ++L)
+    Coef[L] = Cond ? New[L] >> 1 : Coef[L];
+  K -= Cond;
+}
+
+static bool scan(RingMatrix &M, const char *Gates, size_t Size) {
+  uint64_t Seen = 0;
+  for (size_t J = 0; J < Size; ++J) {
+    const LaneOp &Op = GateOps[GateIndex[static_cast<uint8_t>(Gates[J])]];
+    int64_t New[16];
+    applyOp(Op, M.Coef, New);
+    M.K += Op.DK;
+    reduce(New, M.K);
+    reduce(New, M.K);
+    for (int L = 0; L < 16; ++L) {
+      M.Coef[L] = New[L];
+      Seen |= New[L] ^ (New[L] >> 63);
+    }
+    if (Seen >= static_cast<uint64_t>(MaxCoef))
+      return false;
+  }
+  return true;
+}
+#endif
+
+// Z = X * Y in Z[w], where w^4 = -1. Returns false on overflow.
+static bool mulRing(const int64_t *X, const int64_t *Y, int64_t *Z) {
+  for (int K = 0; K < 4; ++K) {
+    int64_t Sum = 0;
+    for (int I = 0; I < 4; ++I) {
+      int J = (K - I + 4) % 4;
+      int64_t Prod;
+      if (__builtin_mul_overflow(X[I], Y[J], &Prod))
+        return false;
+      if (I + J >= 4)
+        Prod = -Prod;
+      if (__builtin_add_overflow(Sum, Prod, &Sum))
+        return false;
+    }
+    Z[K] = Sum;
+  }
+  return true;
+}
+
+// C = A * B, the matrix that applies B first and then A, in reduced form.
+static bool mulMatrix(const RingMatrix &A, const RingMatrix &B,
+                      RingMatrix &C) {
+  for (int Row = 0; Row < 2; ++Row)
+    for (int Col = 0; Col < 2; ++Col) {
+      int64_t P0[4], P1[4];
+      if (!mulRing(A.Coef + Row * 8, B.Coef + Col * 4, P0) ||
+          !mulRing(A.Coef + Row * 8 + 4, B.Coef + 8 + Col * 4, P1))
+        return false;
+      for (int J = 0; J < 4; ++J)
+        if (__builtin_add_overflow(P0[J], P1[J],
+                                   &C.Coef[Row * 8 + Col * 4 + J]))
+          return false;
+    }
+  C.K = A.K + B.K;
+  while (C.K > 0 && divisible(C.Coef) && divisible(C.Coef + 4) &&
+         divisible(C.Coef + 8) && divisible(C.Coef + 12)) {
+    int64_t New[16];
+    for (int L = 0; L < 16; ++L)
+      New[L] = (ReduceOp.Sign[0][L] * C.Coef[ReduceOp.Src[0][L]] +
+                ReduceOp.Sign[1][L] * C.Coef[ReduceOp.Src[1][L]]) >>
+               1;
+    for (int L = 0; L < 16; ++L)
+      C.Coef[L] = New[L];
+    --C.K;
+  }
+  return true;
+}
+
+struct DoubleMatrix {
+  std::complex<double> E[2][2];
+};
+
+static constexpr double InvSqrt2 = 0.70710678118654752440084436210485;
+
+static void materialize(const RingMatrix &M, DoubleMatrix &Out) {
+  double Scale = std::ldexp(M.K % 2 ? InvSqrt2 : 1.0, -(M.K / 2));
+  for (int Row = 0; Row < 2; ++Row)
+    for (int Col = 0; Col < 2; ++Col) {
+      const int64_t *X = M.Coef + Row * 8 + Col * 4;
+      double Re = X[0] + (X[1] - X[3]) * InvSqrt2;
+      double Im = X[2] + (X[1] + X[3]) * InvSqrt2;
+      Out.E[Row][Col] = {Re * Scale, Im * Scale};
+    }
+}
+
+// The fallback for chunks whose coefficients do not fit.
+static void scanDouble(DoubleMatrix &M, const char *Gates, size_t Size) {
+  using namespace std::complex_literals;
+  const std::complex<double> T = {InvSqrt2, InvSqrt2};
+  M.E[0][0] = M.E[1][1] = 1.0;
+  M.E[0][1] = M.E[1][0] = 0.0;
+  for (size_t J = 0; J < Size; ++J) {
+    for (int Col = 0; Col < 2; ++Col) {
+      std::complex<double> A = M.E[0][Col], B = M.E[1][Col];
+      switch (Gates[J]) {
+      case 'H':
+        M.E[0][Col] = (A + B) * InvSqrt2;
+        M.E[1][Col] = (A - B) * InvSqrt2;
+        break;
+      case 'X':
+        M.E[0][Col] = B;
+        M.E[1][Col] = A;
+        break;
+      case 'Y':
+        M.E[0][Col] = B * -1i;
+        M.E[1][Col] = A * 1i;
+        break;
+      case 'Z':
+        M.E[1][Col] = -B;
+        break;
+      case 'S':
+        M.E[1][Col] = B * 1i;
+        break;
+      case 'T':
+        M.E[1][Col] = B * T;
+        break;
+      default:
+        __builtin_unreachable(); // Invalid gate
+      }
+    }
+  }
+}
+
+// Simulate a circuit over "HXYZST". Returns true if the result was computed
+// exactly and only rounded once at the end, or false if some coefficients
+// outgrew int64 and part of the circuit was simulated in double precision.
+bool simulate_exact(size_t N, const char *Gates, std::complex<double> &Alpha,
+                    std::complex<double> &Beta) {
+  int NumThreads = omp_get_max_threads();
+  buildOps();
+
+  std::vector<RingMatrix> Exact(NumThreads);
+  std::vector<DoubleMatrix> Approx(NumThreads);
+  std::vector<uint8_t> IsExact(NumThreads);
+
+#pragma omp parallel for
+  for (int I = 0; I < NumThreads; ++I) {
+    size_t Start = N * I / NumThreads;
+    size_t End = N * (I + 1) / NumThreads;
+    identity(Exact[I]);
+    IsExact[I] = scan(Exact[I], Gates + Start, End - Start);
+    if (IsExact[I])
+      materialize(Exact[I], Approx[I]);
+    else
+      scanDouble(Approx[I], Gates + Start, End - Start);
+  }
+
+  bool AllExact = true;
+  RingMatrix Total;
+  identity(Total);
+  for (int I = 0; I < NumThreads && AllExact; ++I) {
+    RingMatrix Next;
+    AllExact = IsExact[I] && mulMatrix(Exact[I], Total, Next);
+    Total = Next;
+  }
+
+  if (AllExact) {
+    DoubleMatrix M;
+    materialize(Total, M);
+    Alpha = M.E[0][0];
+    Beta = M.E[1][0];
+    return true;
+  }
+
+  Alpha = 1.0;
+  Beta = 0.0;
+  for (auto &M : Approx) {
+    auto NewAlpha = M.E[0][0] * Alpha + M.E[0][1] * Beta;
+    auto NewBeta = M.E[1][0] * Alpha + M.E[1][1] * Beta;
+    Alpha = NewAlpha;
+    Beta = NewBeta;
+  }
+  return false;
+}
+
+void simulate(size_t N, const char *Gates, std::complex<double> &Alpha,
+              std::complex<double> &Beta) {
+  simulate_exact(N, Gates, Alpha, Beta);
+}
@@ -6,101 +6,7 @@
 #include <set>
 #include <utility>
 
-struct Number {
-  using NumberType = int32_t;
-  NumberType Val;
-
-  constexpr static NumberType Zero = 0;
-  constexpr static NumberType PosOne = 1;
-  constexpr static NumberType NegOne = -1;
-  constexpr static NumberType PosInvSqrt2 = 2;
-  constexpr static NumberType NegInvSqrt2 = -2;
-  constexpr static NumberType PosInv2 = 4;
-  constexpr static NumberType NegInv2 = -4;
-
-  constexpr Number(NumberType V) : Val(V) {}
-  Number operator-() const { return {-Val}; }
-
-  // // Compute (A + B) / sqrt(2)
-  Number addDivSqrt2(Number RHS) const {
-    NumberType Sum = Val + RHS.Val;
-    if (Val == Zero || RHS.Val == Zero)
-      return Sum << 1;
-    return Sum >> 2;
-  }
-
-  double materialize() const {
-    switch (Val) {
-    case Zero:
-      return 0.0;
-    case PosOne:
-      return 1.0;
-    case NegOne:
-      return -1.0;
-    case PosInv2:
-      return 0.5;
-    case NegInv2:
-      return -0.5;
-    case PosInvSqrt2:
-      return 0.70710678118654752440084436210485; // 1/sqrt(2)
-    case NegInvSqrt2:
-      return -0.70710678118654752440084436210485; // -1/sqrt(2)
-    default:
-      __builtin_unreachable(); // Invalid value
-    }
-  }
-};
-
-struct Complex {
-  Number Real, Imag;
-  constexpr Complex(Number R) : Real(R), Imag(Number::Zero) {}
-  constexpr Complex(Number R, Number I) : Real(R), Imag(I) {}
-  static constexpr Complex Zero() { return {Number::Zero}; }
-  static constexpr Complex One() { return {Number::PosOne}; }
-  Complex operator-() const { return {-Real, -Imag}; }
-  Complex multiI() const { return {-Imag, Real}; }
-  std::complex<double> materialize() const {
-    return {Real.materialize(), Imag.materialize()};
-  }
-
-  bool operator!=(const Complex &Other) const {
-    return Real.Val != Other.Real.Val || Imag.Val != Other.Imag.Val;
-  }
-  bool operator<(const Complex &Other) const {
-    if (Real.Val != Other.Real.Val)
-      return Real.Val < Other.Real.Val;
-    return Imag.Val < Other.Imag.Val;
-  }
-};
-
-struct Qubit {
-  Complex Alpha, Beta;
-
-  void applyH() {
-    // Alpha = (Alpha + Beta) / sqrt(2)
-    // Beta = (Alpha - Beta) / sqrt(2)
-    auto NewAlphaReal = Alpha.Real.addDivSqrt2(Beta.Real);
-    auto NewAlphaImag = Alpha.Imag.addDivSqrt2(Beta.Imag);
-    auto NewBetaReal = Alpha.Real.addDivSqrt2(-Beta.Real);
-    auto NewBetaImag = Alpha.Imag.addDivSqrt2(-Beta.Imag);
-    Alpha = {NewAlphaReal, NewAlphaImag};
-    Beta = {NewBetaReal, NewBetaImag};
-  }
-  void applyX() { std::swap(Alpha, Beta); }
-  void applyY() {
-    std::swap(Alpha, Beta);
-    Alpha = -Alpha.multiI();
-    Beta = Beta.multiI();
-  }
-  void applyZ() { Beta = -Beta; }
-  void applyS() { Beta = Beta.multiI(); }
-
-  bool operator<(const Qubit &RHS) const {
-    if (Alpha != RHS.Alpha)
-      return Alpha < RHS.Alpha;
-    return Beta < RHS.Beta;
-  }
-};
+#include "symbolic.h"
 
 struct Gate {
   Qubit C1, C2;
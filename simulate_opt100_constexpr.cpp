@@ -0,0 +1,73 @@
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <omp.h>
+#include <vector>
+
+#include "gate_tables.h"
+
+// simulate_opt100 with every table derived at compile time by gate_tables.h
+// instead of simulate_opt90_gen.py, so simulate builds nothing at run time.
+using Tables = GateTables<'H', 'X', 'Y', 'Z', 'S'>;
+
+static constexpr auto &States = Tables::States;
+static constexpr auto &Trans128 = Tables::Trans128;
+static constexpr uint32_t Base0 = Tables::Base0;
+static constexpr uint32_t Base1 = Tables::Base1;
+
+struct Gate {
+  uint32_t C1, C2;
+
+  Gate() : C1{Base0}, C2{Base1} {}
+
+  void apply(std::complex<double> &Alpha, std::complex<double> &Beta) const {
+    std::complex<double> A00 = {States[C1][0], States[C1][1]};
+    std::complex<double> A01 = {States[C2][0], States[C2][1]};
+    std::complex<double> A10 = {States[C1][2], States[C1][3]};
+    std::complex<double> A11 = {States[C2][2], States[C2][3]};
+
+    auto NewAlpha = A00 * Alpha + A01 * Beta;
+    auto NewBeta = A10 * Alpha + A11 * Beta;
+    Alpha = NewAlpha;
+    Beta = NewBeta;
+  }
+};
+
+void simulate(size_t N, const char *Gates, std::complex<double> &Alpha,
+              std::complex<double> &Beta) {
+  int NumThreads = omp_get_max_threads();
+  size_t ChunkSize = N / NumThreads;
+
+  std::vector<Gate> GatesVec(NumThreads);
+
+#pragma omp parallel for
+  for (int I = 0; I < NumThreads; ++I) {
+    size_t Start = I * ChunkSize;
+    const char *GatesPtr = Gates + Start;
+    uint32_t C1 = Base0 << 7;
+    uint32_t C2 = Base1 << 7;
+
+    for (size_t J = 0; J != ChunkSize; J += 8) {
+      uint64_t GateKind = 0;
+      memcpy(&GateKind, GatesPtr + J, sizeof(GateKind));
+      for (int K = 0; K < 7; ++K) {
+        C1 = Trans128[C1 + (GateKind & 255)];
+        C2 = Trans128[C2 + (GateKind & 255)];
+        GateKind >>= 8;
+      }
+      C1 = Trans128[C1 + GateKind];
+      C2 = Trans128[C2 + GateKind];
+    }
+
+    Gate G;
+    G.C1 = C1 >> 7;
+    G.C2 = C2 >> 7;
+    GatesVec[I] = G;
+  }
+
+  Alpha = 1.0;
+  Beta = 0.0;
+  for (auto &G : GatesVec)
+    G.apply(Alpha, Beta);
+}
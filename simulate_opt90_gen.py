@@ -5,6 +5,9 @@ import subprocess
 base_dir = os.path.dirname(os.path.abspath(__file__))
 env = Environment(loader=FileSystemLoader(base_dir), autoescape=select_autoescape())
 
+# Output of simulate_map.cpp. gate_tables.h derives the same tables at compile
+# time for kernels that do not go through this script (simulate_opt90_trans2,
+# simulate_opt90_trans4 and simulate_opt100_constexpr).
 states_str = """0 -4 -4 -4 -4
 1 -4 -4 -4 4
 2 -4 -4 4 -4
@@ -120,6 +123,39 @@ states = [
 mappings = [
     list(map(int, line.split())) for line in mapping_str.splitlines() if line.strip()
 ]
+
+# Enumerate the matrix group generated by HXYZS. Each element is identified by
+# the pair of states its two columns map to (i.e. the images of |0> and |1>).
+base0, base1 = 33, 25
+group = [(base0, base1)]
+group_idx = {(base0, base1): 0}
+words = [[]]
+queue = 0
+while queue < len(group):
+    c1, c2 = group[queue]
+    for gate in range(5):
+        elem = (mappings[c1][gate + 1], mappings[c2][gate + 1])
+        if elem not in group_idx:
+            group_idx[elem] = len(group)
+            group.append(elem)
+            words.append(words[queue] + [gate])
+    queue += 1
+steps = [
+    [group_idx[(mappings[c1][gate + 1], mappings[c2][gate + 1])] for gate in range(5)]
+    for c1, c2 in group
+]
+
+
+# compose[a][b] is the element obtained by applying a first and then b.
+def compose(a, b):
+    for gate in words[b]:
+        a = steps[a][gate]
+    return a
+
+
+composes = [[compose(a, b) for b in range(len(group))] for a in range(len(group))]
+elem_of = [[group_idx.get((c1, c2), 255) for c2 in range(48)] for c1 in range(48)]
+
 template = env.get_template("./simulate_opt90.jinja")
 with open(f"simulate_opt90.cpp", "w") as f:
     f.write(template.render(states=states, mappings=mappings, fp_map=fp_map))
@@ -128,3 +164,159 @@ template = env.get_template("./simulate_opt100.jinja")
 with open(f"simulate_opt100.cpp", "w") as f:
     f.write(template.render(states=states, mappings=mappings, fp_map=fp_map))
 subprocess.run(["clang-format", "-i", "simulate_opt100.cpp"])
+template = env.get_template("./simulate_opt100_group.jinja")
+with open(f"simulate_opt100_group.cpp", "w") as f:
+    f.write(
+        template.render(
+            states=states,
+            group=group,
+            steps=steps,
+            composes=composes,
+            fp_map=fp_map,
+        )
+    )
+subprocess.run(["clang-format", "-i", "simulate_opt100_group.cpp"])
+template = env.get_template("./simulate_opt100_packed.jinja")
+with open(f"simulate_opt100_packed.cpp", "w") as f:
+    f.write(
+        template.render(
+            states=states,
+            mappings=mappings,
+            group=group,
+            elem_of=elem_of,
+            steps=steps,
+            composes=composes,
+            fp_map=fp_map,
+        )
+    )
+subprocess.run(["clang-format", "-i", "simulate_opt100_packed.cpp"])
+template = env.get_template("./simulate_opt100_dynamic.jinja")
+with open(f"simulate_opt100_dynamic.cpp", "w") as f:
+    f.write(
+        template.render(
+            states=states,
+            group=group,
+            steps=steps,
+            composes=composes,
+            fp_map=fp_map,
+        )
+    )
+subprocess.run(["clang-format", "-i", "simulate_opt100_dynamic.cpp"])
+template = env.get_template("./simulate_opt100_streams.jinja")
+with open(f"simulate_opt100_streams.cpp", "w") as f:
+    f.write(
+        template.render(
+            states=states,
+            group=group,
+            steps=steps,
+            composes=composes,
+            fp_map=fp_map,
+        )
+    )
+subprocess.run(["clang-format", "-i", "simulate_opt100_streams.cpp"])
+template = env.get_template("./simulate_opt100_avx512.jinja")
+with open(f"simulate_opt100_avx512.cpp", "w") as f:
+    f.write(
+        template.render(
+            states=states,
+            group=group,
+            steps=steps,
+            composes=composes,
+            fp_map=fp_map,
+        )
+    )
+subprocess.run(["clang-format", "-i", "simulate_opt100_avx512.cpp"])
+template = env.get_template("./simulate_opt100_multi.jinja")
+with open(f"simulate_opt100_multi.cpp", "w") as f:
+    f.write(
+        template.render(
+            states=states,
+            group=group,
+            steps=steps,
+            composes=composes,
+            fp_map=fp_map,
+        )
+    )
+subprocess.run(["clang-format", "-i", "simulate_opt100_multi.cpp"])
+template = env.get_template("./simulate_opt100_incremental.jinja")
+with open(f"simulate_opt100_incremental.cpp", "w") as f:
+    f.write(
+        template.render(
+            states=states,
+            group=group,
+            steps=steps,
+            composes=composes,
+            fp_map=fp_map,
+        )
+    )
+subprocess.run(["clang-format", "-i", "simulate_opt100_incremental.cpp"])
+template = env.get_template("./simulate_opt100_trajectory.jinja")
+with open(f"simulate_opt100_trajectory.cpp", "w") as f:
+    f.write(
+        template.render(
+            states=states,
+            group=group,
+            steps=steps,
+            composes=composes,
+            fp_map=fp_map,
+        )
+    )
+subprocess.run(["clang-format", "-i", "simulate_opt100_trajectory.cpp"])
+template = env.get_template("./simulate_opt100_generate.jinja")
+with open(f"simulate_opt100_generate.cpp", "w") as f:
+    f.write(
+        template.render(
+            states=states,
+            group=group,
+            steps=steps,
+            composes=composes,
+            fp_map=fp_map,
+        )
+    )
+subprocess.run(["clang-format", "-i", "simulate_opt100_generate.cpp"])
+template = env.get_template("./simulate_opt100_vpermb.jinja")
+with open(f"simulate_opt100_vpermb.cpp", "w") as f:
+    f.write(
+        template.render(
+            states=states,
+            mappings=mappings,
+            group=group,
+            elem_of=elem_of,
+            steps=steps,
+            composes=composes,
+            fp_map=fp_map,
+        )
+    )
+subprocess.run(["clang-format", "-i", "simulate_opt100_vpermb.cpp"])
+template = env.get_template("./simulate_opt100_perm.jinja")
+with open(f"simulate_opt100_perm.cpp", "w") as f:
+    f.write(template.render(states=states, mappings=mappings, fp_map=fp_map))
+subprocess.run(["clang-format", "-i", "simulate_opt100_perm.cpp"])
+template = env.get_template("./simulate_opt100_autotune.jinja")
+with open(f"simulate_opt100_autotune.cpp", "w") as f:
+    f.write(
+        template.render(
+            states=states,
+            mappings=mappings,
+            group=group,
+            elem_of=elem_of,
+            composes=composes,
+            fp_map=fp_map,
+        )
+    )
+subprocess.run(["clang-format", "-i", "simulate_opt100_autotune.cpp"])
+template = env.get_template("./simulate_opt100_prefetch.jinja")
+with open(f"simulate_opt100_prefetch.cpp", "w") as f:
+    f.write(template.render(states=states, mappings=mappings, fp_map=fp_map))
+subprocess.run(["clang-format", "-i", "simulate_opt100_prefetch.cpp"])
+template = env.get_template("./simulate_qubits.jinja")
+with open(f"simulate_qubits.cpp", "w") as f:
+    f.write(
+        template.render(
+            states=states,
+            group=group,
+            steps=steps,
+            fp_map=fp_map,
+        )
+    )
+subprocess.run(["clang-format", "-i", "simulate_qubits.cpp"])
@@ -4,21 +4,18 @@
 #include <omp.h>
 #include <vector>
 
-static constexpr double States[48][4] = {
-{% for state in states %}  {{ '{' }}{{ fp_map[state[1]] }}, {{ fp_map[state[2]] }}, {{ fp_map[state[3]] }}, {{ fp_map[state[4]] }}{{ '}' }},
-{% endfor %}
-};
-
-static constexpr uint32_t Base0 = 33;
-static constexpr uint32_t Base1 = 25;
+#include "gate_tables.h"
+#include "simulate_trace.h"
 
-static constexpr uint32_t Trans[48][5] = {
-{% for mapping in mappings %}  {{ '{' }}{{ mapping[1] }}, {{ mapping[2] }}, {{ mapping[3] }}, {{ mapping[4] }}, {{ mapping[5] }}{{ '}' }},
-{% endfor %}
-};
+// Trans4 applies 4 gates at once, indexed by the base-5 number whose
+// most significant digit is the first gate. gate_tables.h derives it at
+// compile time, so simulate builds nothing before the scan.
+using Tables = GateTables<'H', 'X', 'Y', 'Z', 'S'>;
 
-static uint32_t Trans2[48][25];
-static uint32_t Trans4[48][625];
+static constexpr auto &States = Tables::States;
+static constexpr auto &Trans4 = Tables::Fused<4>;
+static constexpr uint32_t Base0 = Tables::Base0;
+static constexpr uint32_t Base1 = Tables::Base1;
 
 struct Gate {
   uint32_t C1, C2;
@@ -30,10 +27,10 @@ struct Gate {
   }
 
   void apply(std::complex<double> &Alpha, std::complex<double> &Beta) const {
-    std::complex<double> A00 = { States[C1][0], States[C1][1] };
-    std::complex<double> A01 = { States[C2][0], States[C2][1] };
-    std::complex<double> A10 = { States[C1][2], States[C1][3] };
-    std::complex<double> A11 = { States[C2][2], States[C2][3] };
+    std::complex<double> A00 = {States[C1][0], States[C1][1]};
+    std::complex<double> A01 = {States[C2][0], States[C2][1]};
+    std::complex<double> A10 = {States[C1][2], States[C1][3]};
+    std::complex<double> A11 = {States[C2][2], States[C2][3]};
 
     auto NewAlpha = A00 * Alpha + A01 * Beta;
     auto NewBeta = A10 * Alpha + A11 * Beta;
@@ -46,21 +43,13 @@ void simulate(size_t N, const char *Gates, std::complex<double> &Alpha,
               std::complex<double> &Beta) {
   int NumThreads = omp_get_max_threads();
   size_t ChunkSize = N / NumThreads;
-
-  for (uint32_t I = 0; I < 48; ++I)
-    for (uint32_t J = 0; J < 5; ++J)
-      for (uint32_t K = 0; K < 5; ++K)
-        Trans2[I][J * 5 + K] = Trans[Trans[I][J]][K];
-
-  for (uint32_t I = 0; I < 48; ++I)
-    for (uint32_t J = 0; J < 25; ++J)
-      for (uint32_t K = 0; K < 25; ++K)
-        Trans4[I][J * 25 + K] = Trans2[Trans2[I][J]][K];
+  TRACE_START();
 
   std::vector<Gate> GatesVec(NumThreads);
 
 #pragma omp parallel for
   for (int I = 0; I < NumThreads; ++I) {
+    TRACE_SCOPE("scan");
     Gate G;
     size_t Start = I * ChunkSize;
     const char *GatesPtr = Gates + Start;
@@ -152,8 +141,11 @@ void simulate(size_t N, const char *Gates, std::complex<double> &Alpha,
     GatesVec[I] = G;
   }
 
-  Alpha = 1.0;
-  Beta = 0.0;
-  for (auto &G : GatesVec)
-    G.apply(Alpha, Beta);
+  {
+    TRACE_SCOPE("combine");
+    Alpha = 1.0;
+    Beta = 0.0;
+    for (auto &G : GatesVec)
+      G.apply(Alpha, Beta);
+  }
 }
@@ -12,7 +12,6 @@ for i in range(batch):
         for seq in seqs:
             new_seqs.append(seq + next)
     seqs = new_seqs
-print(seqs)
 indexed_seqs = []
 for seq in seqs:
     gates = []
@@ -21,6 +20,6 @@ for seq in seqs:
         tag = tag * 5 + "HXYZS".index(gate)
         gates.append(gate)
     indexed_seqs.append((tag, gates))
-template = env.get_template("./simulate_opt100.jinja")
+template = env.get_template("./simulate_opt_fusion.jinja")
 with open(f"simulate_opt100_batch{batch}.cpp", "w") as f:
     f.write(template.render(seqs=indexed_seqs, step=batch))
@@ -0,0 +1,371 @@
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+#include <omp.h>
+#include <type_traits>
+#include <vector>
+
+// Simulation of circuits of arbitrary-angle rotations. No finite table
+// exists, so each thread multiplies 2x2 complex matrices: its chunk is split
+// into 8 sub-chains, one per lane of an AVX-512 register, which advance in
+// lockstep. The per-lane and per-thread products are then combined by a
+// tree reduction. With Compensated set, the matrices are accumulated in
+// double-double arithmetic, so the rounding of the products no longer
+// accumulates and the error is dominated by that of the gate entries.
+
+// Axis is 'X', 'Y' or 'Z' for Rx, Ry or Rz by Theta radians, where
+// R_A(Theta) = exp(-i Theta / 2 A).
+struct RotationGate {
+  char Axis;
+  double Theta;
+};
+
+// An unevaluated sum Hi + Lo with |Lo| <= ulp(Hi) / 2.
+struct DD {
+  double Hi = 0, Lo = 0;
+};
+
+static inline DD twoSum(double A, double B) {
+  double S = A + B;
+  double BB = S - A;
+  return {S, (A - (S - BB)) + (B - BB)};
+}
+
+static inline DD add(DD X, DD Y) {
+  DD S = twoSum(X.Hi, Y.Hi);
+  double E = S.Lo + X.Lo + Y.Lo;
+  double Hi = S.Hi + E;
+  return {Hi, E - (Hi - S.Hi)};
+}
+
+static inline DD mul(DD X, DD Y) {
+  double P = X.Hi * Y.Hi;
+  double E = std::fma(X.Hi, Y.Hi, -P) + X.Hi * Y.Lo + X.Lo * Y.Hi;
+  double Hi = P + E;
+  return {Hi, E - (Hi - P)};
+}
+
+static inline DD neg(DD X) { return {-X.Hi, -X.Lo}; }
+
+// Entry (R, C) is Re[R][C] + i Im[R][C].
+struct Matrix {
+  DD Re[2][2], Im[2][2];
+};
+
+static Matrix identity() {
+  Matrix M;
+  M.Re[0][0].Hi = M.Re[1][1].Hi = 1.0;
+  return M;
+}
+
+// The matrix that applies B first and then A.
+static Matrix mul(const Matrix &A, const Matrix &B) {
+  Matrix C;
+  for (int R = 0; R < 2; ++R)
+    for (int Col = 0; Col < 2; ++Col)
+      for (int S = 0; S < 2; ++S) {
+        C.Re[R][Col] = add(C.Re[R][Col], mul(A.Re[R][S], B.Re[S][Col]));
+        C.Re[R][Col] =
+            add(C.Re[R][Col], neg(mul(A.Im[R][S], B.Im[S][Col])));
+        C.Im[R][Col] = add(C.Im[R][Col], mul(A.Re[R][S], B.Im[S][Col]));
+        C.Im[R][Col] = add(C.Im[R][Col], mul(A.Im[R][S], B.Re[S][Col]));
+      }
+  return C;
+}
+
+static Matrix gateMatrix(const RotationGate &G) {
+  double S = std::sin(G.Theta / 2), C = std::cos(G.Theta / 2);
+  Matrix M;
+  M.Re[0][0].Hi = M.Re[1][1].Hi = C;
+  switch (G.Axis) {
+  case 'X':
+    M.Im[0][1].Hi = M.Im[1][0].Hi = -S;
+    break;
+  case 'Y':
+    M.Re[0][1].Hi = -S;
+    M.Re[1][0].Hi = S;
+    break;
+  case 'Z':
+    M.Im[0][0].Hi = -S;
+    M.Im[1][1].Hi = S;
+    break;
+  default:
+    __builtin_unreachable(); // Invalid gate
+  }
+  return M;
+}
+
+// Apply Size gates one at a time, for remainders and hosts without AVX-512.
+static Matrix scanScalar(const RotationGate *Gates, size_t Size) {
+  Matrix M = identity();
+  for (size_t J = 0; J < Size; ++J)
+    M = mul(gateMatrix(Gates[J]), M);
+  return M;
+}
+
+#if defined(__AVX512F__)
+// sin and cos of 8 angles: reduction by multiples of pi/2 in three parts,
+// then the kernel polynomials of fdlibm on [-pi/4, pi/4]. Their errors are
+// close to unbiased, which matters more here than the peak error, since a
+// bias in S^2 + C^2 compounds over every gate.
+static inline void sinCos(__m512d X, __m512d &Sin, __m512d &Cos) {
+  const __m512d Zero = _mm512_setzero_pd();
+  __m512d J = _mm512_roundscale_pd(
+      _mm512_mul_pd(X, _mm512_set1_pd(0.63661977236758134308)),
+      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  __m512d R =
+      _mm512_fnmadd_pd(J, _mm512_set1_pd(1.57079632673412561417e+00), X);
+  R = _mm512_fnmadd_pd(J, _mm512_set1_pd(6.07710050630396597660e-11), R);
+  R = _mm512_fnmadd_pd(J, _mm512_set1_pd(2.02226624879595063154e-21), R);
+  // The low bits of J + 1.5 * 2^52 are J mod 2^k.
+  __m512i Q = _mm512_castpd_si512(
+      _mm512_add_pd(J, _mm512_set1_pd(6755399441055744.0)));
+
+  __m512d Z = _mm512_mul_pd(R, R);
+  __m512d PS = _mm512_set1_pd(1.58969099521155010221e-10);
+  PS = _mm512_fmadd_pd(PS, Z, _mm512_set1_pd(-2.50507602534068634195e-08));
+  PS = _mm512_fmadd_pd(PS, Z, _mm512_set1_pd(2.75573137070700676789e-06));
+  PS = _mm512_fmadd_pd(PS, Z, _mm512_set1_pd(-1.98412698298579493134e-04));
+  PS = _mm512_fmadd_pd(PS, Z, _mm512_set1_pd(8.33333333332248946124e-03));
+  PS = _mm512_fmadd_pd(PS, Z, _mm512_set1_pd(-1.66666666666666324348e-01));
+  __m512d S = _mm512_fmadd_pd(_mm512_mul_pd(R, Z), PS, R);
+  __m512d PC = _mm512_set1_pd(-1.13596475577881948265e-11);
+  PC = _mm512_fmadd_pd(PC, Z, _mm512_set1_pd(2.08757232129817482790e-09));
+  PC = _mm512_fmadd_pd(PC, Z, _mm512_set1_pd(-2.75573143513906633035e-07));
+  PC = _mm512_fmadd_pd(PC, Z, _mm512_set1_pd(2.48015872894767294178e-05));
+  PC = _mm512_fmadd_pd(PC, Z, _mm512_set1_pd(-1.38888888888741095749e-03));
+  PC = _mm512_fmadd_pd(PC, Z, _mm512_set1_pd(4.16666666666666019037e-02));
+  // 1 - Z / 2 with the rounding errors of Z and of the subtraction carried
+  // into the small terms.
+  __m512d HZ = _mm512_mul_pd(_mm512_set1_pd(0.5), Z);
+  __m512d W = _mm512_sub_pd(_mm512_set1_pd(1.0), HZ);
+  __m512d Tail = _mm512_sub_pd(_mm512_sub_pd(_mm512_set1_pd(1.0), W), HZ);
+  Tail = _mm512_fnmadd_pd(_mm512_set1_pd(0.5), _mm512_fmsub_pd(R, R, Z), Tail);
+  __m512d C = _mm512_add_pd(W, _mm512_fmadd_pd(_mm512_mul_pd(Z, Z), PC, Tail));
+
+  // Quadrant Q: sin is S, C, -S, -C and cos is C, -S, -C, S.
+  __mmask8 Swap = _mm512_test_epi64_mask(Q, _mm512_set1_epi64(1));
+  __mmask8 NegSin = _mm512_test_epi64_mask(Q, _mm512_set1_epi64(2));
+  __mmask8 NegCos = _mm512_test_epi64_mask(
+      _mm512_add_epi64(Q, _mm512_set1_epi64(1)), _mm512_set1_epi64(2));
+  Sin = _mm512_mask_blend_pd(Swap, S, C);
+  Cos = _mm512_mask_blend_pd(Swap, C, S);
+  Sin = _mm512_mask_sub_pd(Sin, NegSin, Zero, Sin);
+  Cos = _mm512_mask_sub_pd(Cos, NegCos, Zero, Cos);
+}
+
+// The entries of 8 gate matrices, one per lane. Re01 = -Re10 and
+// Im01 = Im10 for every rotation, and Re00 = Re11.
+struct VecGate {
+  __m512d Re00, Im00, Im11, Re10, Im10;
+};
+
+// Load the gates at element offsets Index (premultiplied by 2, as a
+// RotationGate is two 8-byte words) and build their matrices.
+static inline VecGate loadGates(const RotationGate *Gates, __m512i Index) {
+  const double *Words = reinterpret_cast<const double *>(Gates);
+  __m512d Theta = _mm512_i64gather_pd(
+      _mm512_add_epi64(Index, _mm512_set1_epi64(1)), Words, 8);
+  __m512i Axis = _mm512_and_si512(
+      _mm512_i64gather_epi64(Index, Words, 8), _mm512_set1_epi64(255));
+  __mmask8 IsX = _mm512_cmpeq_epi64_mask(Axis, _mm512_set1_epi64('X'));
+  __mmask8 IsY = _mm512_cmpeq_epi64_mask(Axis, _mm512_set1_epi64('Y'));
+  __mmask8 IsZ = _mm512_cmpeq_epi64_mask(Axis, _mm512_set1_epi64('Z'));
+  __m512d S, C;
+  sinCos(_mm512_mul_pd(Theta, _mm512_set1_pd(0.5)), S, C);
+  __m512d NegS = _mm512_sub_pd(_mm512_setzero_pd(), S);
+  return {C, _mm512_maskz_mov_pd(IsZ, NegS), _mm512_maskz_mov_pd(IsZ, S),
+          _mm512_maskz_mov_pd(IsY, S), _mm512_maskz_mov_pd(IsX, NegS)};
+}
+
+// The two entries of one column of 8 matrices.
+struct VecColumn {
+  __m512d Re0, Im0, Re1, Im1;
+};
+
+// Column <- G * Column.
+static inline void apply(const VecGate &G, VecColumn &M) {
+  // Row 0: (Re00 + i Im00) M0 + (-Re10 + i Im10) M1.
+  __m512d Re0 = _mm512_fmsub_pd(G.Re00, M.Re0, _mm512_mul_pd(G.Im00, M.Im0));
+  Re0 = _mm512_sub_pd(
+      Re0, _mm512_fmadd_pd(G.Re10, M.Re1, _mm512_mul_pd(G.Im10, M.Im1)));
+  __m512d Im0 = _mm512_fmadd_pd(G.Re00, M.Im0, _mm512_mul_pd(G.Im00, M.Re0));
+  Im0 = _mm512_add_pd(
+      Im0, _mm512_fmsub_pd(G.Im10, M.Re1, _mm512_mul_pd(G.Re10, M.Im1)));
+  // Row 1: (Re10 + i Im10) M0 + (Re00 + i Im11) M1.
+  __m512d Re1 = _mm512_fmsub_pd(G.Re10, M.Re0, _mm512_mul_pd(G.Im10, M.Im0));
+  Re1 = _mm512_add_pd(
+      Re1, _mm512_fmsub_pd(G.Re00, M.Re1, _mm512_mul_pd(G.Im11, M.Im1)));
+  __m512d Im1 = _mm512_fmadd_pd(G.Re10, M.Im0, _mm512_mul_pd(G.Im10, M.Re0));
+  Im1 = _mm512_add_pd(
+      Im1, _mm512_fmadd_pd(G.Re00, M.Im1, _mm512_mul_pd(G.Im11, M.Re1)));
+  M = {Re0, Im0, Re1, Im1};
+}
+
+// Double-double counterparts of the above, one lane per sub-chain.
+struct VecDD {
+  __m512d Hi, Lo;
+};
+
+static inline VecDD add(VecDD X, VecDD Y) {
+  __m512d S = _mm512_add_pd(X.Hi, Y.Hi);
+  __m512d BB = _mm512_sub_pd(S, X.Hi);
+  __m512d E = _mm512_add_pd(_mm512_sub_pd(X.Hi, _mm512_sub_pd(S, BB)),
+                            _mm512_sub_pd(Y.Hi, BB));
+  E = _mm512_add_pd(E, _mm512_add_pd(X.Lo, Y.Lo));
+  __m512d Hi = _mm512_add_pd(S, E);
+  return {Hi, _mm512_sub_pd(E, _mm512_sub_pd(Hi, S))};
+}
+
+// X * G for a double G.
+static inline VecDD mul(VecDD X, __m512d G) {
+  __m512d P = _mm512_mul_pd(X.Hi, G);
+  __m512d E = _mm512_fmadd_pd(X.Lo, G, _mm512_fmsub_pd(X.Hi, G, P));
+  __m512d Hi = _mm512_add_pd(P, E);
+  return {Hi, _mm512_sub_pd(E, _mm512_sub_pd(Hi, P))};
+}
+
+struct VecColumnDD {
+  VecDD Re0, Im0, Re1, Im1;
+};
+
+static inline void apply(const VecGate &G, VecColumnDD &M) {
+  const __m512d Zero = _mm512_setzero_pd();
+  __m512d NegIm00 = _mm512_sub_pd(Zero, G.Im00);
+  __m512d NegIm10 = _mm512_sub_pd(Zero, G.Im10);
+  __m512d NegIm11 = _mm512_sub_pd(Zero, G.Im11);
+  __m512d NegRe10 = _mm512_sub_pd(Zero, G.Re10);
+  VecDD Re0 = add(add(mul(M.Re0, G.Re00), mul(M.Im0, NegIm00)),
+                  add(mul(M.Re1, NegRe10), mul(M.Im1, NegIm10)));
+  VecDD Im0 = add(add(mul(M.Im0, G.Re00), mul(M.Re0, G.Im00)),
+                  add(mul(M.Im1, NegRe10), mul(M.Re1, G.Im10)));
+  VecDD Re1 = add(add(mul(M.Re0, G.Re10), mul(M.Im0, NegIm10)),
+                  add(mul(M.Re1, G.Re00), mul(M.Im1, NegIm11)));
+  VecDD Im1 = add(add(mul(M.Im0, G.Re10), mul(M.Re0, G.Im10)),
+                  add(mul(M.Im1, G.Re00), mul(M.Re1, G.Im11)));
+  M = {Re0, Im0, Re1, Im1};
+}
+
+static inline VecDD toDD(__m512d X) { return {X, _mm512_setzero_pd()}; }
+
+static void store(const VecColumn &M, Matrix *Out, int Col) {
+  alignas(64) double Buf[4][8];
+  _mm512_store_pd(Buf[0], M.Re0);
+  _mm512_store_pd(Buf[1], M.Im0);
+  _mm512_store_pd(Buf[2], M.Re1);
+  _mm512_store_pd(Buf[3], M.Im1);
+  for (int L = 0; L < 8; ++L) {
+    Out[L].Re[0][Col] = {Buf[0][L], 0};
+    Out[L].Im[0][Col] = {Buf[1][L], 0};
+    Out[L].Re[1][Col] = {Buf[2][L], 0};
+    Out[L].Im[1][Col] = {Buf[3][L], 0};
+  }
+}
+
+static void store(const VecColumnDD &M, Matrix *Out, int Col) {
+  alignas(64) double Buf[8][8];
+  const VecDD *Parts[4] = {&M.Re0, &M.Im0, &M.Re1, &M.Im1};
+  for (int P = 0; P < 4; ++P) {
+    _mm512_store_pd(Buf[2 * P], Parts[P]->Hi);
+    _mm512_store_pd(Buf[2 * P + 1], Parts[P]->Lo);
+  }
+  for (int L = 0; L < 8; ++L) {
+    Out[L].Re[0][Col] = {Buf[0][L], Buf[1][L]};
+    Out[L].Im[0][Col] = {Buf[2][L], Buf[3][L]};
+    Out[L].Re[1][Col] = {Buf[4][L], Buf[5][L]};
+    Out[L].Im[1][Col] = {Buf[6][L], Buf[7][L]};
+  }
+}
+
+// Product of 8 sub-chains of SubSize gates each, lane L starting at gate
+// L * SubSize.
+template <typename Column>
+static void scanLanes(const RotationGate *Gates, size_t SubSize,
+                      Matrix Out[8]) {
+  const __m512d Zero = _mm512_setzero_pd(), One = _mm512_set1_pd(1.0);
+  Column Col0, Col1;
+  if constexpr (std::is_same_v<Column, VecColumn>) {
+    Col0 = {One, Zero, Zero, Zero};
+    Col1 = {Zero, Zero, One, Zero};
+  } else {
+    Col0 = {toDD(One), toDD(Zero), toDD(Zero), toDD(Zero)};
+    Col1 = {toDD(Zero), toDD(Zero), toDD(One), toDD(Zero)};
+  }
+  // Lane L reads the doubles of gate L * SubSize. Built without a 64-bit
+  // multiply, which would need AVX512DQ.
+  const long long Step = 2 * SubSize;
+  __m512i Index = _mm512_setr_epi64(0, Step, 2 * Step, 3 * Step, 4 * Step,
+                                    5 * Step, 6 * Step, 7 * Step);
+  const __m512i Two = _mm512_set1_epi64(2);
+  for (size_t J = 0; J < SubSize; ++J) {
+    VecGate G = loadGates(Gates, Index);
+    apply(G, Col0);
+    apply(G, Col1);
+    Index = _mm512_add_epi64(Index, Two);
+  }
+  store(Col0, Out, 0);
+  store(Col1, Out, 1);
+}
+
+// Multiply Items[0 .. Count - 1] in order, later items applied last, by
+// combining neighbours pairwise.
+static Matrix treeProduct(Matrix *Items, int Count) {
+  for (int Stride = 1; Stride < Count; Stride *= 2)
+    for (int I = 0; I + Stride < Count; I += 2 * Stride)
+      Items[I] = mul(Items[I + Stride], Items[I]);
+  return Items[0];
+}
+#endif
+
+static Matrix scanChunk(const RotationGate *Gates, size_t Size,
+                        bool Compensated) {
+#if defined(__AVX512F__)
+  Matrix Lanes[9];
+  size_t SubSize = Size / 8;
+  if (Compensated)
+    scanLanes<VecColumnDD>(Gates, SubSize, Lanes);
+  else
+    scanLanes<VecColumn>(Gates, SubSize, Lanes);
+  Lanes[8] = scanScalar(Gates + 8 * SubSize, Size - 8 * SubSize);
+  return treeProduct(Lanes, 9);
+#else
+  (void)Compensated;
+  return scanScalar(Gates, Size);
+#endif
+}
+
+void simulate_rotations(size_t N, const RotationGate *Gates, bool Compensated,
+                        std::complex<double> &Alpha,
+                        std::complex<double> &Beta) {
+  int NumThreads = omp_get_max_threads();
+  std::vector<Matrix> Results(NumThreads, identity());
+
+#pragma omp parallel
+  {
+    int I = omp_get_thread_num();
+    int T = omp_get_num_threads();
+    size_t Start = N * I / T;
+    size_t End = N * (I + 1) / T;
+    Results[I] = scanChunk(Gates + Start, End - Start, Compensated);
+
+    // Tree reduction: after the round with stride S, Results[I] for I a
+    // multiple of 2S holds the product of chunks I .. I + 2S - 1.
+    for (int Stride = 1; Stride < T; Stride *= 2) {
+#pragma omp barrier
+#pragma omp for
+      for (int J = 0; J < T - Stride; J += 2 * Stride)
+        Results[J] = mul(Results[J + Stride], Results[J]);
+    }
+  }
+
+  // The state reached from |0> is the first column. Any drift of its norm
+  // away from 1 is rounding error common to both amplitudes.
+  const Matrix &M = Results[0];
+  Alpha = {M.Re[0][0].Hi + M.Re[0][0].Lo, M.Im[0][0].Hi + M.Im[0][0].Lo};
+  Beta = {M.Re[1][0].Hi + M.Re[1][0].Lo, M.Im[1][0].Hi + M.Im[1][0].Lo};
+  double Scale = 1.0 / std::sqrt(std::norm(Alpha) + std::norm(Beta));
+  Alpha *= Scale;
+  Beta *= Scale;
+}
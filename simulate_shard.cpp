@@ -0,0 +1,76 @@
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <omp.h>
+#include <vector>
+
+#include "gate_tables.h"
+
+// The group-element kernel split into its two halves, so that the scan and
+// the combine can run in different processes: simulate_summary reduces any
+// range of gates to one of the 192 matrices, and compose_summaries combines
+// the summaries of consecutive ranges. driver_shard moves the summaries
+// between processes.
+using Tables = GateTables<'H', 'X', 'Y', 'Z', 'S'>;
+
+static constexpr auto &States = Tables::States;
+static constexpr auto &Columns = Tables::Columns;
+static constexpr auto &Step128 = Tables::Step128;
+static constexpr auto &Compose = Tables::Compose;
+static constexpr uint32_t Identity = Tables::Identity;
+
+// A shard starts at an arbitrary byte of the file, so neither the pointer
+// nor the length is assumed to be a multiple of 8.
+static uint32_t scanRange(const char *GatesPtr, size_t Size) {
+  uint32_t G = Identity << 7;
+  size_t J = 0;
+  for (; J + 8 <= Size; J += 8) {
+    uint64_t GateKind = 0;
+    memcpy(&GateKind, GatesPtr + J, sizeof(GateKind));
+    for (int K = 0; K < 7; ++K) {
+      G = Step128[G + (GateKind & 255)];
+      GateKind >>= 8;
+    }
+    G = Step128[G + GateKind];
+  }
+  for (; J != Size; ++J)
+    G = Step128[G + static_cast<uint8_t>(GatesPtr[J])];
+  return G >> 7;
+}
+
+uint32_t compose_summaries(const uint32_t *Summaries, size_t Count) {
+  uint32_t Total = Identity;
+  for (size_t I = 0; I < Count; ++I)
+    Total = Compose[Total][Summaries[I]];
+  return Total;
+}
+
+// The matrix of the N gates. The OpenMP threads scan their slices in
+// parallel, and the slice summaries are then composed in order.
+uint32_t simulate_summary(size_t N, const char *Gates) {
+  int NumThreads = omp_get_max_threads();
+  std::vector<uint32_t> GatesVec(NumThreads, Identity);
+
+#pragma omp parallel for
+  for (int I = 0; I < NumThreads; ++I) {
+    size_t Start = N * I / NumThreads;
+    size_t End = N * (I + 1) / NumThreads;
+    GatesVec[I] = scanRange(Gates + Start, End - Start);
+  }
+
+  return compose_summaries(GatesVec.data(), GatesVec.size());
+}
+
+// The state reached from |0> by the matrix Summary.
+void summary_state(uint32_t Summary, std::complex<double> &Alpha,
+                   std::complex<double> &Beta) {
+  const double *Col = States[Columns[Summary][0]];
+  Alpha = {Col[0], Col[1]};
+  Beta = {Col[2], Col[3]};
+}
+
+void simulate(size_t N, const char *Gates, std::complex<double> &Alpha,
+              std::complex<double> &Beta) {
+  summary_state(simulate_summary(N, Gates), Alpha, Beta);
+}
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <omp.h>
+#include <random>
+#include <vector>
+
+// Stabilizer simulation of Clifford circuits after Aaronson and Gottesman,
+// "Improved simulation of stabilizer circuits" (2004). The tableau has 2n
+// rows, n destabilizers followed by n stabilizers, each a Pauli product
+// with X bits, Z bits and a sign bit R.
+
+// Kind is one of "HXYZS" for a single-qubit gate on Target, or 'C' for a
+// CNOT flipping Target when Control is set.
+struct QubitGate {
+  char Kind;
+  uint16_t Target, Control;
+};
+
+// 512 tableau rows, one bit each. Loops over Bits compile to one zmm
+// operation with AVX-512.
+struct alignas(64) RowBlock {
+  uint64_t Bits[8];
+};
+
+static constexpr size_t RowsPerBlock = 512;
+
+// Gates act on every row independently, so the rows are stored by column:
+// block B holds, for each qubit Q, the X and Z bits of rows 512B .. 512B+511
+// at X[B * n + Q] and Z[B * n + Q]. Each thread takes whole blocks and runs
+// the entire gate stream over them without synchronization.
+static void applyGates(size_t N, const QubitGate *Gates, size_t NumQubits,
+                       RowBlock *X, RowBlock *Z, RowBlock *R) {
+  size_t NumBlocks = (2 * NumQubits + RowsPerBlock - 1) / RowsPerBlock;
+#pragma omp parallel for schedule(static)
+  for (size_t B = 0; B < NumBlocks; ++B) {
+    RowBlock *XB = X + B * NumQubits, *ZB = Z + B * NumQubits;
+    uint64_t *RB = R[B].Bits;
+    for (size_t I = 0; I < N; ++I) {
+      uint64_t *XT = XB[Gates[I].Target].Bits;
+      uint64_t *ZT = ZB[Gates[I].Target].Bits;
+      switch (Gates[I].Kind) {
+      case 'H':
+        for (int L = 0; L < 8; ++L) {
+          RB[L] ^= XT[L] & ZT[L];
+          std::swap(XT[L], ZT[L]);
+        }
+        break;
+      case 'S':
+        for (int L = 0; L < 8; ++L) {
+          RB[L] ^= XT[L] & ZT[L];
+          ZT[L] ^= XT[L];
+        }
+        break;
+      case 'X':
+        for (int L = 0; L < 8; ++L)
+          RB[L] ^= ZT[L];
+        break;
+      case 'Y':
+        for (int L = 0; L < 8; ++L)
+          RB[L] ^= XT[L] ^ ZT[L];
+        break;
+      case 'Z':
+        for (int L = 0; L < 8; ++L)
+          RB[L] ^= XT[L];
+        break;
+      case 'C': {
+        uint64_t *XC = XB[Gates[I].Control].Bits;
+        uint64_t *ZC = ZB[Gates[I].Control].Bits;
+        for (int L = 0; L < 8; ++L) {
+          RB[L] ^= XC[L] & ZT[L] & ~(XT[L] ^ ZC[L]);
+          XT[L] ^= XC[L];
+          ZC[L] ^= ZT[L];
+        }
+        break;
+      }
+      default:
+        __builtin_unreachable(); // Invalid gate
+      }
+    }
+  }
+}
+
+// The tableau by rows for measurement, which combines whole rows. Row I
+// occupies Words 64-bit words of X and of Z starting at I * Words.
+struct Rows {
+  size_t Words;
+  std::vector<uint64_t> X, Z;
+  std::vector<uint8_t> R;
+
+  uint64_t *x(size_t I) { return X.data() + I * Words; }
+  uint64_t *z(size_t I) { return Z.data() + I * Words; }
+  bool xBit(size_t I, size_t Q) { return x(I)[Q / 64] >> (Q % 64) & 1; }
+
+  void clear(size_t I) {
+    std::fill(x(I), x(I) + Words, 0);
+    std::fill(z(I), z(I) + Words, 0);
+    R[I] = 0;
+  }
+
+  void copy(size_t To, size_t From) {
+    std::copy(x(From), x(From) + Words, x(To));
+    std::copy(z(From), z(From) + Words, z(To));
+    R[To] = R[From];
+  }
+
+  // Multiply row H by row I, tracking the sign. The power of i picked up on
+  // each qubit is +1 or -1 on the sets Pos and Neg below.
+  void rowsum(size_t H, size_t I) {
+    uint64_t *X1 = x(I), *Z1 = z(I), *X2 = x(H), *Z2 = z(H);
+    int64_t Sum = 2 * R[H] + 2 * R[I];
+    for (size_t W = 0; W < Words; ++W) {
+      uint64_t A = X1[W], B = Z1[W], C = X2[W], D = Z2[W];
+      uint64_t Pos = (A & B & ~C & D) | (A & ~B & C & D) | (~A & B & C & ~D);
+      uint64_t Neg = (A & B & C & ~D) | (A & ~B & ~C & D) | (~A & B & C & D);
+      Sum += __builtin_popcountll(Pos) - __builtin_popcountll(Neg);
+      X2[W] = A ^ C;
+      Z2[W] = B ^ D;
+    }
+    R[H] = (Sum & 3) == 2;
+  }
+};
+
+static Rows transpose(size_t NumQubits, const RowBlock *X, const RowBlock *Z,
+                      const RowBlock *R) {
+  size_t NumRows = 2 * NumQubits;
+  Rows T;
+  T.Words = (NumQubits + 63) / 64;
+  // One extra scratch row for deterministic measurements.
+  T.X.assign((NumRows + 1) * T.Words, 0);
+  T.Z.assign((NumRows + 1) * T.Words, 0);
+  T.R.assign(NumRows + 1, 0);
+#pragma omp parallel for schedule(static)
+  for (size_t I = 0; I < NumRows; ++I) {
+    size_t B = I / RowsPerBlock, L = I / 64 % 8, Bit = I % 64;
+    for (size_t Q = 0; Q < NumQubits; ++Q) {
+      T.x(I)[Q / 64] |= (X[B * NumQubits + Q].Bits[L] >> Bit & 1) << (Q % 64);
+      T.z(I)[Q / 64] |= (Z[B * NumQubits + Q].Bits[L] >> Bit & 1) << (Q % 64);
+    }
+    T.R[I] = R[B].Bits[L] >> Bit & 1;
+  }
+  return T;
+}
+
+// Measure qubit Q in the computational basis. Returns the outcome and sets
+// Random if it was not determined by the state.
+static bool measure(Rows &T, size_t NumQubits, size_t Q, std::mt19937_64 &Rng,
+                    bool &Random) {
+  size_t NumRows = 2 * NumQubits;
+  size_t P = NumQubits;
+  while (P < NumRows && !T.xBit(P, Q))
+    ++P;
+
+  Random = P < NumRows;
+  if (Random) {
+    // Some stabilizer anticommutes with Z_Q: the outcome is uniform, and
+    // every other row that anticommutes is multiplied by row P.
+#pragma omp parallel for schedule(static)
+    for (size_t I = 0; I < NumRows; ++I)
+      if (I != P && T.xBit(I, Q))
+        T.rowsum(I, P);
+    T.copy(P - NumQubits, P);
+    T.clear(P);
+    bool Outcome = Rng() & 1;
+    T.z(P)[Q / 64] = uint64_t(1) << (Q % 64);
+    T.R[P] = Outcome;
+    return Outcome;
+  }
+
+  // Z_Q is in the stabilizer group: recover its sign in the scratch row from
+  // the stabilizers paired with destabilizers that anticommute with it.
+  size_t Scratch = NumRows;
+  T.clear(Scratch);
+  for (size_t I = 0; I < NumQubits; ++I)
+    if (T.xBit(I, Q))
+      T.rowsum(Scratch, I + NumQubits);
+  return T.R[Scratch];
+}
+
+// Run N gates on NumQubits qubits starting from |0...0>, then measure every
+// qubit in order. Outcomes[Q] receives the result of qubit Q and Random[Q]
+// whether it was random; random outcomes are drawn from Seed.
+void simulate_stabilizer(size_t N, const QubitGate *Gates, size_t NumQubits,
+                         uint64_t Seed, uint8_t *Outcomes, uint8_t *Random) {
+  size_t NumBlocks = (2 * NumQubits + RowsPerBlock - 1) / RowsPerBlock;
+  std::vector<RowBlock> X(NumBlocks * NumQubits), Z(NumBlocks * NumQubits);
+  std::vector<RowBlock> R(NumBlocks);
+
+  // Destabilizer Q is X_Q and stabilizer Q is Z_Q.
+#pragma omp parallel for schedule(static)
+  for (size_t B = 0; B < NumBlocks; ++B) {
+    for (size_t Q = 0; Q < NumQubits; ++Q) {
+      X[B * NumQubits + Q] = {};
+      Z[B * NumQubits + Q] = {};
+    }
+    R[B] = {};
+  }
+  for (size_t Q = 0; Q < NumQubits; ++Q) {
+    size_t Destab = Q, Stab = NumQubits + Q;
+    X[Destab / RowsPerBlock * NumQubits + Q].Bits[Destab / 64 % 8] |=
+        uint64_t(1) << (Destab % 64);
+    Z[Stab / RowsPerBlock * NumQubits + Q].Bits[Stab / 64 % 8] |=
+        uint64_t(1) << (Stab % 64);
+  }
+
+  applyGates(N, Gates, NumQubits, X.data(), Z.data(), R.data());
+
+  Rows T = transpose(NumQubits, X.data(), Z.data(), R.data());
+  std::mt19937_64 Rng(Seed);
+  for (size_t Q = 0; Q < NumQubits; ++Q) {
+    bool IsRandom;
+    Outcomes[Q] = measure(T, NumQubits, Q, Rng, IsRandom);
+    Random[Q] = IsRandom;
+  }
+}
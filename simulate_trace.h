@@ -0,0 +1,146 @@
+#ifndef SIMULATE_TRACE_H
+#define SIMULATE_TRACE_H
+
+// Phase tracing, compiled in with -DSIMULATE_TRACE. Each thread appends
+// (name, begin, end) records to its own buffer, so tracing takes no locks.
+// Nothing is printed while simulate runs, since the driver times the whole
+// call: at exit, the per-phase times, thread imbalance and start skew of
+// the last traced call go to stderr, and a Chrome trace to
+// $SIMULATE_TRACE_FILE if set. Without SIMULATE_TRACE the macros expand to
+// nothing.
+#ifdef SIMULATE_TRACE
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <omp.h>
+#include <string>
+#include <vector>
+
+struct TraceEvent {
+  const char *Name;
+  double Begin, End; // Microseconds since TRACE_START.
+};
+
+static std::chrono::steady_clock::time_point TraceOrigin;
+static std::vector<std::vector<TraceEvent>> TraceEvents;
+static std::string TraceNotes;
+
+static double traceNow() {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - TraceOrigin)
+      .count();
+}
+
+struct TraceScope {
+  const char *Name;
+  double Begin;
+  explicit TraceScope(const char *Name) : Name(Name), Begin(traceNow()) {}
+  ~TraceScope() {
+    TraceEvents[omp_get_thread_num()].push_back({Name, Begin, traceNow()});
+  }
+};
+
+static void traceReport();
+
+static void traceStart() {
+  static bool Registered = false;
+  if (!Registered) {
+    atexit(traceReport);
+    Registered = true;
+  }
+  TraceNotes.clear();
+  TraceEvents.assign(omp_get_max_threads(), {});
+  for (auto &Events : TraceEvents)
+    Events.reserve(64);
+  TraceOrigin = std::chrono::steady_clock::now();
+}
+
+template <typename... Args>
+static void traceNote(const char *Format, Args... Values) {
+  char Line[256];
+  snprintf(Line, sizeof(Line), Format, Values...);
+  TraceNotes += Line;
+}
+
+static void traceReport() {
+  // Phases in order of first appearance, with the total time each thread
+  // spent in them and when each thread first entered them.
+  std::vector<std::string> Phases;
+  std::vector<std::vector<double>> Busy, Entry;
+  for (size_t T = 0; T < TraceEvents.size(); ++T) {
+    for (auto &E : TraceEvents[T]) {
+      size_t P =
+          std::find(Phases.begin(), Phases.end(), E.Name) - Phases.begin();
+      if (P == Phases.size()) {
+        Phases.push_back(E.Name);
+        Busy.emplace_back(TraceEvents.size(), 0.0);
+        Entry.emplace_back(TraceEvents.size(), -1.0);
+      }
+      Busy[P][T] += E.End - E.Begin;
+      if (Entry[P][T] < 0)
+        Entry[P][T] = E.Begin;
+    }
+  }
+
+  // Imbalance is max / mean - 1 over the threads that ran the phase, and
+  // skew is how much later than the first thread the last one entered it.
+  fprintf(stderr, "%-16s %8s %11s %11s %11s %10s %10s\n", "phase",
+          "threads", "mean (ms)", "max (ms)", "min (ms)", "imbalance",
+          "skew (ms)");
+  for (size_t P = 0; P < Phases.size(); ++P) {
+    double Sum = 0, Max = 0, Min = 1e300, FirstEntry = 1e300, LastEntry = 0;
+    int Threads = 0;
+    for (size_t T = 0; T < TraceEvents.size(); ++T) {
+      if (Entry[P][T] < 0)
+        continue;
+      ++Threads;
+      Sum += Busy[P][T];
+      Max = std::max(Max, Busy[P][T]);
+      Min = std::min(Min, Busy[P][T]);
+      FirstEntry = std::min(FirstEntry, Entry[P][T]);
+      LastEntry = std::max(LastEntry, Entry[P][T]);
+    }
+    double Mean = Sum / Threads;
+    fprintf(stderr, "%-16s %8d %11.3f %11.3f %11.3f %9.1f%% %10.3f\n",
+            Phases[P].c_str(), Threads, Mean / 1e3, Max / 1e3, Min / 1e3,
+            Mean > 0 ? 100 * (Max / Mean - 1) : 0.0,
+            (LastEntry - FirstEntry) / 1e3);
+  }
+  fputs(TraceNotes.c_str(), stderr);
+
+  const char *Path = getenv("SIMULATE_TRACE_FILE");
+  if (!Path)
+    return;
+  FILE *File = fopen(Path, "w");
+  if (!File) {
+    perror("Failed to open trace file");
+    return;
+  }
+  fprintf(File, "{\"traceEvents\": [");
+  bool First = true;
+  for (size_t T = 0; T < TraceEvents.size(); ++T) {
+    for (auto &E : TraceEvents[T]) {
+      fprintf(File,
+              "%s\n  {\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, "
+              "\"tid\": %zu, \"ts\": %.3f, \"dur\": %.3f}",
+              First ? "" : ",", E.Name, T, E.Begin, E.End - E.Begin);
+      First = false;
+    }
+  }
+  fprintf(File, "\n]}\n");
+  fclose(File);
+}
+
+#define TRACE_START() traceStart()
+#define TRACE_SCOPE(Name) TraceScope Scope(Name)
+// A free-form line for the report, e.g. a parameter the kernel chose. The
+// arguments are not evaluated without SIMULATE_TRACE.
+#define TRACE_NOTE(...) traceNote(__VA_ARGS__)
+#else
+#define TRACE_START()
+#define TRACE_SCOPE(Name)
+#define TRACE_NOTE(...)
+#endif
+
+#endif // SIMULATE_TRACE_H
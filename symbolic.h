@@ -0,0 +1,117 @@
+#ifndef SYMBOLIC_H
+#define SYMBOLIC_H
+
+#include <complex>
+#include <cstdint>
+
+// Exact single-qubit amplitudes for the HXYZS gate set. Every amplitude
+// reachable from |0> is 0, +-1, +-1/sqrt(2) or +-1/2 (times 1 or i), so each
+// real part is encoded as a small integer. All operations are constexpr so
+// that gate_tables.h can enumerate the reachable states at compile time.
+
+struct Number {
+  using NumberType = int32_t;
+  NumberType Val;
+
+  constexpr static NumberType Zero = 0;
+  constexpr static NumberType PosOne = 1;
+  constexpr static NumberType NegOne = -1;
+  constexpr static NumberType PosInvSqrt2 = 2;
+  constexpr static NumberType NegInvSqrt2 = -2;
+  constexpr static NumberType PosInv2 = 4;
+  constexpr static NumberType NegInv2 = -4;
+
+  constexpr Number(NumberType V) : Val(V) {}
+  constexpr Number operator-() const { return {-Val}; }
+
+  // Compute (A + B) / sqrt(2)
+  constexpr Number addDivSqrt2(Number RHS) const {
+    NumberType Sum = Val + RHS.Val;
+    if (Val == Zero || RHS.Val == Zero)
+      return Sum * 2;
+    return Sum >> 2;
+  }
+
+  constexpr double materialize() const {
+    switch (Val) {
+    case Zero:
+      return 0.0;
+    case PosOne:
+      return 1.0;
+    case NegOne:
+      return -1.0;
+    case PosInv2:
+      return 0.5;
+    case NegInv2:
+      return -0.5;
+    case PosInvSqrt2:
+      return 0.70710678118654752440084436210485; // 1/sqrt(2)
+    case NegInvSqrt2:
+      return -0.70710678118654752440084436210485; // -1/sqrt(2)
+    default:
+      __builtin_unreachable(); // Invalid value
+    }
+  }
+};
+
+struct Complex {
+  Number Real, Imag;
+  constexpr Complex() : Real(Number::Zero), Imag(Number::Zero) {}
+  constexpr Complex(Number R) : Real(R), Imag(Number::Zero) {}
+  constexpr Complex(Number R, Number I) : Real(R), Imag(I) {}
+  static constexpr Complex Zero() { return {Number::Zero}; }
+  static constexpr Complex One() { return {Number::PosOne}; }
+  constexpr Complex operator-() const { return {-Real, -Imag}; }
+  constexpr Complex multiI() const { return {-Imag, Real}; }
+  std::complex<double> materialize() const {
+    return {Real.materialize(), Imag.materialize()};
+  }
+
+  constexpr bool operator!=(const Complex &Other) const {
+    return Real.Val != Other.Real.Val || Imag.Val != Other.Imag.Val;
+  }
+  constexpr bool operator<(const Complex &Other) const {
+    if (Real.Val != Other.Real.Val)
+      return Real.Val < Other.Real.Val;
+    return Imag.Val < Other.Imag.Val;
+  }
+};
+
+struct Qubit {
+  Complex Alpha, Beta;
+
+  constexpr void applyH() {
+    // Alpha = (Alpha + Beta) / sqrt(2)
+    // Beta = (Alpha - Beta) / sqrt(2)
+    auto NewAlphaReal = Alpha.Real.addDivSqrt2(Beta.Real);
+    auto NewAlphaImag = Alpha.Imag.addDivSqrt2(Beta.Imag);
+    auto NewBetaReal = Alpha.Real.addDivSqrt2(-Beta.Real);
+    auto NewBetaImag = Alpha.Imag.addDivSqrt2(-Beta.Imag);
+    Alpha = {NewAlphaReal, NewAlphaImag};
+    Beta = {NewBetaReal, NewBetaImag};
+  }
+  // std::swap is not constexpr before C++20.
+  constexpr void applyX() {
+    Complex Tmp = Alpha;
+    Alpha = Beta;
+    Beta = Tmp;
+  }
+  constexpr void applyY() {
+    applyX();
+    Alpha = -Alpha.multiI();
+    Beta = Beta.multiI();
+  }
+  constexpr void applyZ() { Beta = -Beta; }
+  constexpr void applyS() { Beta = Beta.multiI(); }
+
+  constexpr bool operator!=(const Qubit &RHS) const {
+    return Alpha != RHS.Alpha || Beta != RHS.Beta;
+  }
+  constexpr bool operator<(const Qubit &RHS) const {
+    if (Alpha != RHS.Alpha)
+      return Alpha < RHS.Alpha;
+    return Beta < RHS.Beta;
+  }
+};
+
+#endif // SYMBOLIC_H